@@ -2,17 +2,28 @@
  * Copyright (C) 2022 ArcNyxx
  * see LICENCE file for licensing information */
 
+#define _GNU_SOURCE /* posix_spawn setsid and closefrom */
+
+#include <errno.h>
+#include <spawn.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <X11/Xlib.h>
 
 #include "act.h"
+#include "bar.h"
 #include "conv.h"
 #include "config.h"
 #include "func.h"
+#include "ipc.h"
+#include "launch.h"
+#include "path.h"
 #include "struct.h"
 #include "tile.h"
+#include "trace.h"
 #include "util.h"
 
 extern Display *dpy;
@@ -91,30 +102,55 @@ setmfact(const Arg arg)
 	/* arg > 100 will set mfact absolutely */
 	int newmfact = arg.n > 100 ? arg.n - 100 : sel->mfact + arg.n;
 	if (newmfact >= 5 && newmfact <= 95) {
+		TRACEIN(mark, dpy);
 		sel->mfact = newmfact;
 		tile(sel);
+		TRACEOUT(mark, "setmfact", dpy);
 	}
 }
 
 void
 spawn(const Arg arg)
 {
-	if (fork() == 0) {
-		if (dpy != NULL)
-			close(ConnectionNumber(dpy));
-		setsid();
-		execvp(((char *const *)arg.v)[0], (char *const *)arg.v);
-		die("swim: unable to run %s: ", ((char *const *)arg.v)[0]);
-	}
+	/* the child shares memory until it execs, so no page tables are
+	 * copied, and keeps no descriptors above stderr */
+	extern char **environ;
+	char *const *argv = arg.v;
+	pid_t pid;
+	posix_spawnattr_t attr;
+	posix_spawn_file_actions_t acts;
+
+	posix_spawnattr_init(&attr);
+#ifdef POSIX_SPAWN_SETSID
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+#else
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+#endif /* POSIX_SPAWN_SETSID */
+	posix_spawn_file_actions_init(&acts);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 34)
+	posix_spawn_file_actions_addclosefrom_np(&acts, STDERR_FILENO + 1);
+#endif /* __GLIBC__ */
+
+	if ((errno = posix_spawnp(&pid, argv[0], &acts, &attr, argv,
+			environ)) != 0)
+		fprintf(stderr, "swim: unable to run %s: %s\n", argv[0],
+				strerror(errno));
+	else
+		addlaunch(pid, argv[0]);
+	posix_spawn_file_actions_destroy(&acts);
+	posix_spawnattr_destroy(&attr);
 }
 
 void
 startexec(const Arg arg)
 {
 	extern int exec;
+	extern char execc[256];
 	exec = 0;
 	XGrabKey(dpy, AnyKey, AnyModifier, RootWindow(dpy, DefaultScreen(dpy)),
 			true, GrabModeAsync, GrabModeAsync);
+	completepath("", execc, sizeof(execc));
+	drawbar(sel);
 }
 
 void
@@ -180,6 +216,7 @@ toggleview(const Arg arg)
 	unsigned int newtags;
 	if ((newtags = sel->tags ^ (arg.n & TAG)) != 0) {
 		sel->tags = newtags;
+		ipcevent("view %d %d", monnum(sel), sel->tags);
 		focus(NULL);
 		tile(sel);
 	}
@@ -189,9 +226,12 @@ void
 view(const Arg arg)
 {
 	if ((arg.n & TAG) != 0) {
+		TRACEIN(mark, dpy);
 		sel->tags = arg.n & TAG;
+		ipcevent("view %d %d", monnum(sel), sel->tags);
 		focus(NULL);
 		tile(sel);
+		TRACEOUT(mark, "view", dpy);
 	}
 }
 
@@ -203,9 +243,11 @@ zoom(const Arg arg)
 		return;
 	if (cli != nexttiled(sel->clients) || (cli != NULL &&
 			(cli = nexttiled(cli->next)) != NULL)) {
+		TRACEIN(mark, dpy);
 		detach(cli);
 		cli->next = cli->mon->clients, cli->mon->clients = cli;
 		focus(cli);
 		tile(cli->mon);
+		TRACEOUT(mark, "zoom", dpy);
 	}
 }
@@ -2,75 +2,340 @@
  * Copyright (C) 2022 ArcNyxx
  * see LICENCE file for licensing information */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <X11/Xlib.h>
+
 #include "bar.h"
 #include "config.h"
 #include "drw.h"
 #include "struct.h"
+#include "tile.h"
+#include "trace.h"
 #include "util.h"
 
 #define BOXS (PADW / 9)
 #define BOXW (PADW / 6 + 2)
 
+/* tag cell states, each a row of the cell atlas */
+#define CELLURG 3
+#define CELLSEL 6
+#define CELLS   12
+
+#define SLOTS 16    /* monitors with a bar, more is fatal */
+#define DIRTY 4     /* middle buffer holds an unrendered snapshot */
+
+typedef struct {
+	Window win;
+	unsigned int full; /* drawbar calls, a change redraws the whole bar */
+	int ww, tags, occ, urg, seltags, selmon;
+	int exec, hassel, isfloating, isfixed;
+	char status[256], title[520]; /* fits prompt and completions */
+} Snap;
+
+/* triple buffer, the producer fills back and swaps it with mid and the
+ * renderer swaps front with mid when it is marked dirty */
+typedef struct {
+	Snap buf[3];
+	int mid, back, front;
+	unsigned int full; bool used; /* owned by the producer */
+	unsigned int drawn; int stw; /* owned by the renderer */
+	char status[256];
+} Slot;
+
+static void drawcells(void);
+static void post(const Monitor *mon, bool full);
+static void redrawstatus(Slot *slot, const Snap *snap, int tw);
+static void render(Slot *slot);
+static void *renderbars(void *null);
+
+static Drw *drw;
+static Slot slots[SLOTS];
+static int wake[2];
+static int stw; /* width of status text last drawn, read by any thread */
+static Pixmap cells;
+static const Fnt *cellfnt;
+static int cellx[LENGTH(tags) + 1]; /* read by any thread once ready */
+static bool cellready;
+
 extern Monitor *sel, *mons;
-extern Drw *drw;
 extern Clr **scheme;
 
-void
-drawbar(const Monitor *mon)
+static void
+drawcells(void)
 {
-	extern int exec;
-	extern char stext[256], execa[256];
+	__atomic_store_n(&cellx[0], 0, __ATOMIC_RELAXED);
+	for (int i = 0; i < LENGTH(tags); ++i)
+		__atomic_store_n(&cellx[i + 1], cellx[i] +
+				drw_fontset_getwidth(drw, tags[i]) + PADW,
+				__ATOMIC_RELAXED);
+	__atomic_store_n(&cellready, true, __ATOMIC_RELEASE);
+	if (cells != 0)
+		XFreePixmap(drw->dpy, cells);
+	cells = XCreatePixmap(drw->dpy, drw->root, cellx[LENGTH(tags)],
+			CELLS * PADH, DefaultDepth(drw->dpy, drw->screen));
+	cellfnt = drw->fonts;
+
+	/* occupancy is none, occupied or occupied by the selected client */
+	for (int cell = 0; cell < CELLS; ++cell) {
+		int occ = cell % CELLURG, urg = cell / CELLURG % 2;
+		drw_setscheme(drw, scheme[cell >= CELLSEL ? ClrSel : ClrNorm]);
+		for (int i = 0; i < LENGTH(tags); ++i) {
+			drw_text(drw, cellx[i], 0, cellx[i + 1] - cellx[i],
+					PADH, PADW / 2, tags[i], urg);
+			if (occ != 0)
+				drw_rect(drw, cellx[i] + BOXS, BOXS, BOXW,
+						BOXW, occ == 2, urg);
+		}
+		XCopyArea(drw->dpy, drw->drawable, cells, drw->gc, 0, 0,
+				cellx[LENGTH(tags)], PADH, 0, cell * PADH);
+	}
+}
+
+static void
+redrawstatus(Slot *slot, const Snap *snap, int tw)
+{
+	/* only the text between what the status shares at either end with
+	 * the one drawn last is drawn, widths are sums of advances so the
+	 * ends stay where they were */
+	const char *old = slot->status, *new = snap->status;
+	size_t pre = 0, suf = 0, olen = strlen(old), nlen = strlen(new);
+	while (new[pre] != '\0' && new[pre] == old[pre])
+		++pre;
+	if (pre == nlen && pre == olen)
+		return;
+	while (suf < nlen - pre && suf < olen - pre &&
+			new[nlen - suf - 1] == old[olen - suf - 1])
+		++suf;
+	while (pre > 0 && (new[pre] & 0xC0) == 0x80)
+		--pre;
+	while (suf > 0 && (new[nlen - suf] & 0xC0) == 0x80)
+		--suf;
 
-	if (!mon->showbar)
+	char buf[sizeof(snap->status)];
+	memcpy(buf, new, pre), buf[pre] = '\0';
+	int x = snap->ww - tw + drw_fontset_getwidth(drw, buf);
+	int w = snap->ww - drw_fontset_getwidth(drw, &new[nlen - suf]) - x;
+	memcpy(buf, &new[pre], nlen - suf - pre), buf[nlen - suf - pre] = '\0';
+	strcpy(slot->status, new);
+	if (w <= 0)
 		return;
+	drw_text(drw, x, 0, w, PADH, 0, buf, 0);
+	drw_map(drw, snap->win, x, 0, w, PADH);
+}
 
-	int x, w, tw = 0;
+static void
+render(Slot *slot)
+{
+	const Snap *snap = &slot->buf[slot->front];
+	if (cellfnt != drw->fonts)
+		drawcells();
+	if ((unsigned int)snap->ww > drw->w)
+		drw_resize(drw, snap->ww, PADH);
+
+	int x, w, tw = drw_fontset_getwidth(drw, snap->status);
+	__atomic_store_n(&stw, tw, __ATOMIC_RELAXED);
 	drw_setscheme(drw, scheme[ClrNorm]);
-	tw = drw_fontset_getwidth(drw, stext);
-	drw_text(drw, mon->ww - tw, 0, tw, PADH, 0, stext, 0);
 
-	int occ = 0, urg = 0;
-	for (Client *cli = mon->clients; cli != NULL; cli = cli->next)
-		occ |= cli->tags, urg |= cli->isurgent ? cli->tags : 0;
+	/* the rest of the bar only moves if the status changes width */
+	if (snap->full == slot->drawn && tw == slot->stw) {
+		redrawstatus(slot, snap, tw);
+		return;
+	}
+	slot->drawn = snap->full, slot->stw = tw;
+	drw_text(drw, snap->ww - tw, 0, tw, PADH, 0, snap->status, 0);
+	strcpy(slot->status, snap->status);
 
-	x = 0;
+	/* tag cells are copied from their prerendered state */
 	for (int i = 0; i < LENGTH(tags); ++i) {
-		w = drw_fontset_getwidth(drw, tags[i]) + PADW;
-		drw_setscheme(drw, scheme[mon->tags & 1 << i ?
-				ClrSel : ClrNorm]);
-		drw_text(drw, x, 0, w, PADH, PADW / 2,
-				tags[i], (urg & 1 << i) != 0);
-		if ((occ & 1 << i) != 0)
-			drw_rect(drw, x + BOXS, BOXS, BOXW, BOXW,
-					mon == sel && sel->sel != NULL &&
-					(sel->sel->tags & 1 << i) != 0,
-					(urg & 1 << 1) != 0);
-		x += w;
+		int cell = (snap->tags & 1 << i ? CELLSEL : 0) +
+				(snap->urg & 1 << i ? CELLURG : 0);
+		if ((snap->occ & 1 << i) != 0)
+			cell += (snap->seltags & 1 << i) != 0 ? 2 : 1;
+		XCopyArea(drw->dpy, cells, drw->drawable, drw->gc, cellx[i],
+				cell * PADH, cellx[i + 1] - cellx[i], PADH,
+				cellx[i], 0);
 	}
+	x = cellx[LENGTH(tags)];
 
-	if ((w = mon->ww - tw - x) > PADW) {
-		if (exec != -1) {
+	if ((w = snap->ww - tw - x) > PADW) {
+		if (snap->exec) {
 			drw_setscheme(drw, scheme[ClrSel]);
-			drw_text(drw, x, 0, w, PADH, PADW / 2, execa, 0);
-		} else if (mon->sel != NULL) {
-			drw_setscheme(drw, scheme[mon == sel ?
+			drw_text(drw, x, 0, w, PADH, PADW / 2, snap->title, 0);
+		} else if (snap->hassel) {
+			drw_setscheme(drw, scheme[snap->selmon ?
 					ClrSel : ClrNorm]);
-			drw_text(drw, x, 0, w, PADH, PADW / 2,
-					mon->sel->name, 0);
-			if (mon->sel->isfloating)
+			drw_text(drw, x, 0, w, PADH, PADW / 2, snap->title, 0);
+			if (snap->isfloating)
 				drw_rect(drw, x + BOXS, BOXS, BOXW, BOXW,
-						mon->sel->isfixed, 0);
+						snap->isfixed, 0);
 		} else {
 			drw_setscheme(drw, scheme[ClrNorm]);
 			drw_rect(drw, x, 0, w, PADH, 1, 1);
 		}
 	}
-	drw_map(drw, mon->barwin, 0, 0, mon->ww, PADH);
+	drw_map(drw, snap->win, 0, 0, snap->ww, PADH);
+}
+
+static void *
+renderbars(void *null)
+{
+	/* fonts load here so that startup need not wait on fontconfig */
+	if (!drw_fontset_create(drw, font))
+		die("swim: unable to create fonts\n");
+	drawcells();
+	timing("fonts");
+
+	char buf[64];
+	bool painted = false;
+	struct pollfd pfd = { .fd = wake[0], .events = POLLIN };
+	for (;;) {
+		/* drained before the slots are checked, so a snapshot posted
+		 * after the check always leaves a byte to wake on */
+		while (read(wake[0], buf, sizeof(buf)) > 0);
+		for (int i = 0; i < SLOTS; ++i) {
+			if ((__atomic_load_n(&slots[i].mid, __ATOMIC_ACQUIRE) &
+					DIRTY) == 0)
+				continue;
+			slots[i].front = __atomic_exchange_n(&slots[i].mid,
+					slots[i].front, __ATOMIC_ACQ_REL) & ~DIRTY;
+			TRACEIN(mark, drw->dpy);
+			render(&slots[i]);
+			TRACEOUT(mark, "render", drw->dpy);
+			if (!painted)
+				XSync(drw->dpy, false), timing("paint"),
+						painted = true;
+		}
+		poll(&pfd, 1, -1);
+	}
+	return NULL;
+}
+
+int
+clickbar(const Monitor *mon, int x, int *tag)
+{
+	/* tags are measured once the bar thread has loaded the fonts, a
+	 * click on a bar not yet painted hits nothing */
+	if (!__atomic_load_n(&cellready, __ATOMIC_ACQUIRE))
+		return -1;
+
+	for (*tag = 0; *tag < LENGTH(tags); ++*tag)
+		if (x < __atomic_load_n(&cellx[*tag + 1], __ATOMIC_RELAXED))
+			return ClkTagBar;
+	if (x > mon->ww - __atomic_load_n(&stw, __ATOMIC_RELAXED) + PADW)
+		return ClkStatusText;
+	return ClkWinTitle;
+}
+
+static void
+post(const Monitor *mon, bool full)
+{
+	extern int exec;
+	extern char stext[256], execa[256], execc[256];
+
+	/* bars under fullscreen clients are redrawn once they leave */
+	if (!mon->showbar || nextfull(mon->clients) != NULL)
+		return;
+
+	Slot *slot = &slots[mon->bar];
+	slot->full += full;
+	Snap *snap = &slot->buf[slot->back];
+	snap->win = mon->barwin, snap->ww = mon->ww, snap->full = slot->full;
+	snap->tags = mon->tags, snap->occ = snap->urg = 0;
+	for (Client *cli = mon->clients; cli != NULL; cli = cli->next)
+		snap->occ |= cli->tags, snap->urg |= cli->isurgent ?
+				cli->tags : 0;
+	snap->selmon = mon == sel;
+	snap->seltags = mon == sel && sel->sel != NULL ? sel->sel->tags : 0;
+	snap->exec = exec != -1, snap->hassel = mon->sel != NULL;
+	snap->isfloating = snap->hassel && mon->sel->isfloating;
+	snap->isfixed = snap->hassel && mon->sel->isfixed;
+	strcpy(snap->status, stext);
+	if (snap->exec)
+		snprintf(snap->title, sizeof(snap->title), "%s  %s", execa,
+				execc);
+	else
+		strcpy(snap->title, snap->hassel ? mon->sel->name : "");
+
+	slot->back = __atomic_exchange_n(&slot->mid, slot->back | DIRTY,
+			__ATOMIC_ACQ_REL) & ~DIRTY;
+	/* a full pipe means the renderer is yet to wake */
+	if (write(wake[1], "", 1) == -1 && errno != EAGAIN)
+		die("swim: unable to wake bar thread");
+}
+
+void
+freebar(int bar)
+{
+	slots[bar].used = false;
+}
+
+int
+newbar(void)
+{
+	/* kept by a monitor for its life, so others leaving do not move it */
+	for (int i = 0; i < SLOTS; ++i)
+		if (!slots[i].used) {
+			slots[i].used = true;
+			return i;
+		}
+	die("swim: unable to give more than %d monitors a bar\n", SLOTS);
+	return -1;
+}
+
+void
+drawbar(const Monitor *mon)
+{
+	post(mon, true);
 }
 
 void
 drawbars(void)
 {
 	for (Monitor *mon = mons; mon != NULL; mon = mon->next)
-		drawbar(mon);
+		post(mon, true);
+}
+
+void
+drawstatus(void)
+{
+	for (Monitor *mon = mons; mon != NULL; mon = mon->next)
+		post(mon, false);
+}
+
+void
+startbar(void)
+{
+	/* the renderer has its own connection so that text never holds up
+	 * the event loop, only it touches xft once it is started */
+	Display *bdpy;
+	if ((bdpy = XOpenDisplay(NULL)) == NULL)
+		die("swim: unable to open display\n");
+	fcntl(ConnectionNumber(bdpy), F_SETFD, FD_CLOEXEC);
+	drw = drw_create(bdpy, DefaultScreen(bdpy), RootWindow(bdpy,
+			DefaultScreen(bdpy)), DisplayWidth(bdpy,
+			DefaultScreen(bdpy)), PADH);
+	scheme = scalloc(LENGTH(colors), sizeof(Clr *));
+	for (int i = 0; i < LENGTH(colors); ++i)
+		scheme[i] = drw_scm_create(drw, colors[i], 3);
+
+	for (int i = 0; i < SLOTS; ++i)
+		slots[i].back = 0, slots[i].mid = 1, slots[i].front = 2,
+				slots[i].drawn = ~0u;
+	if (pipe(wake) == -1)
+		die("swim: unable to create pipe");
+	for (int i = 0; i < 2; ++i)
+		fcntl(wake[i], F_SETFL, O_NONBLOCK),
+				fcntl(wake[i], F_SETFD, FD_CLOEXEC);
+
+	pthread_t thread;
+	if ((errno = pthread_create(&thread, NULL, renderbars, NULL)) != 0)
+		die("swim: unable to create bar thread");
 }
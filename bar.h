@@ -7,7 +7,12 @@
 
 #include "struct.h"
 
+int clickbar(const Monitor *mon, int x, int *tag);
 void drawbar(const Monitor *mon);
 void drawbars(void);
+void drawstatus(void);
+void freebar(int bar);
+int newbar(void);
+void startbar(void);
 
 #endif /* BAR_H */
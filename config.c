@@ -9,6 +9,7 @@
 
 #include "struct.h"
 #include "act.h"
+#include "mod.h"
 
 #define MODKEY Mod4Mask
 #define TAGKEY(keysym, shift)                                                 \
@@ -24,6 +25,8 @@ const int  nmaster = 1;  /* number of clients in master area */
 const bool showbar = 1;  /* show status bar */
 
 const char *font         = "monospace:size=10";
+const char *statusfifo   = NULL; /* fifo to read status lines from */
+const char *ipcsocket    = NULL; /* socket to take commands from */
 const char *tags[9]      = { "1", "2", "3", "4", "5", "6", "7", "8", "9" };
 const char *colors[2][3] = {
 	[ClrNorm] = { "#bbbbbb", "#222222", "#444444" },
@@ -83,3 +86,41 @@ const Button buttons[4] = {
 	{ ClkTagBar, MODKEY, Button1, tag,        { 0 } },
 	{ ClkTagBar, MODKEY, Button3, toggletag,  { 0 } },
 };
+
+/* status modules, shown after any status text and refreshed every interval
+ * seconds, none by default as the entry with no func is skipped; modbattery
+ * and modnet read files such as /sys/class/power_supply/BAT0/capacity and
+ * /sys/class/net/eth0/statistics/rx_bytes */
+const Module modules[1] = {
+	{ NULL },
+	/* { modcpu,   "/proc/stat",    "cpu %lld%%", 2 }, */
+	/* { modmem,   "/proc/meminfo", "mem %lld%%", 5 }, */
+	/* { modclock, NULL,            "%a %d %b %H:%M", 1 }, */
+};
+
+/* window rules, class and instance match exactly, title matches any
+ * substring and type is a _NET_WM_WINDOW_TYPE atom name; a tags of zero
+ * keeps the tags of the monitor and a mon of -1 the selected monitor */
+const Rule rules[2] = {
+	/* class, instance, title, type, tags, mon, isfloating, x, y, w, h */
+	{ "Gimp", NULL, NULL, NULL, 0, -1, 1, 0, 0, 0, 0 },
+	{ NULL, NULL, NULL, "_NET_WM_WINDOW_TYPE_SPLASH", 0, -1, 1,
+			0, 0, 0, 0 },
+};
+
+/* most X requests and round trips a traced span may take before a warning
+ * is printed, checked if TRACE is defined; counted from the worst path
+ * through each with no client buttons, two monitors already known and no
+ * client asking for fullscreen, a client costing one configure, synthetic
+ * configure and sync for its resize, a restack and at most one size hints
+ * fetch; raise one only with the change that needs it */
+const Budget budgets[7] = {
+	/* span, requests, round trips, each per client */
+	{ "maprequest",      33, 14, 4, 2 },
+	{ "focus",           10,  2, 0, 0 },
+	{ "view",            12,  3, 4, 2 },
+	{ "zoom",            12,  3, 4, 2 },
+	{ "setmfact",         2,  1, 4, 2 },
+	{ "updatetitle",      2,  2, 0, 0 },
+	{ "configurenotify", 17,  5, 4, 2 },
+};
@@ -16,19 +16,30 @@
 
 #define TOPB
 /* #define RHINTS */
+/* #define FULLICONIC */
+/* #define TRACE */
+/* #define TRACEUSDT */
 #define PADW 16
 #define PADH 20
 
+#define STATUSRATE 10
+#define TITLERATE 4
+
 extern const int  borderw;
 extern const int  mfact;
 extern const int  nmaster;
 extern const bool showbar;
 
 extern const char *font;
+extern const char *statusfifo;
+extern const char *ipcsocket;
 extern const char *tags[9];
 extern const char *colors[2][3];
 
 extern const Key keys[59];
 extern const Button buttons[4];
+extern const Module modules[1];
+extern const Rule rules[2];
+extern const Budget budgets[7];
 
 #endif /* CONFIG_H */
@@ -14,7 +14,8 @@ WPROFILE = -Wall -Wextra -Wstrict-prototypes -Wmissing-declarations \
 -Wno-implicit-fallthrough
 INC = -I/usr/X11R6/include -I/usr/include/freetype2
 STD = -D_DEFAULT_SOURCE -D_POSIX_C_SOURCE=200809L -DXINERAMA
-LIB = -L/usr/X11R6/lib -lX11 -lXinerama -lfontconfig -lXft -lxkbcommon
+LIB = -L/usr/X11R6/lib -lX11 -lXinerama -lfontconfig -lXft -lxkbcommon \
+-lpthread
 
 CFLAGS = $(WPROFILE) $(INC) $(STD) -Os
 LDFLAGS = $(LIB)
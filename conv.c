@@ -6,11 +6,20 @@
 
 #include "conv.h"
 #include "struct.h"
+#include "trace.h"
 #include "util.h"
 
 extern Display *dpy;
 extern Monitor *sel, *mons;
 
+int
+monnum(const Monitor *mon)
+{
+	int num = 0;
+	for (const Monitor *iter = mons; iter != mon; iter = iter->next, ++num);
+	return num;
+}
+
 Monitor *
 rectomon(int x, int y, int w, int h)
 {
@@ -58,11 +67,17 @@ wintomon(Window win)
 	Client *client;
 	Window dummy, root = RootWindow(dpy, DefaultScreen(dpy));
 
-	if (win == root && XQueryPointer(dpy, root, &dummy, &dummy, &x, &y,
-			&null, &null, (unsigned int *)&null))
-		return rectomon(x, y, 1, 1);
+	if (win == root) {
+		TRACEIN(mark, dpy);
+		TRACETRIP();
+		Bool got = XQueryPointer(dpy, root, &dummy, &dummy, &x, &y,
+				&null, &null, (unsigned int *)&null);
+		TRACEOUT(mark, "XQueryPointer", dpy);
+		if (got)
+			return rectomon(x, y, 1, 1);
+	}
 	for (Monitor *mon = mons; mon != NULL; mon = mon->next)
-		if (win == mon->barwin)
+		if (win == mon->barwin || win == mon->inwin)
 			return mon;
 	if ((client = wintocli(win)))
 		return client->mon;
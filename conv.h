@@ -7,6 +7,7 @@
 
 #include "struct.h"
 
+int      monnum(const Monitor *mon);
 Monitor *rectomon(int x, int y, int w, int h);
 Monitor *dirtomon(int dir);
 Client  *wintocli(Window win);
@@ -9,6 +9,19 @@
 #include "utf8.h"
 #include "util.h"
 
+#define ADVDENSE 0x300  /* codepoints kept in the dense advance table */
+#define ADVNONE  0xFFFF /* advance not yet looked up */
+#define FBCACHE  256    /* codepoint to fallback font cache slots */
+#define FBWAYS   4      /* slots a codepoint may be cached in */
+#define FBFONTS  8      /* fallback fonts kept open */
+
+typedef struct {
+	wchar_t cp[256];
+	unsigned char len[256];
+	size_t pos, num;
+	const char *end; /* terminator of the string being decoded */
+} Utf8buf;
+
 Drw *
 drw_create(Display *dpy, int screen, Window root, unsigned int w, unsigned int h)
 {
@@ -21,6 +34,9 @@ drw_create(Display *dpy, int screen, Window root, unsigned int w, unsigned int h
 	drw->h = h;
 	drw->drawable = XCreatePixmap(dpy, root, w, h, DefaultDepth(dpy, screen));
 	drw->gc = XCreateGC(dpy, root, 0, NULL);
+	drw->fbcache = scalloc(FBCACHE, sizeof(Fbk));
+	drw->xftdraw = XftDrawCreate(dpy, drw->drawable, DefaultVisual(dpy, screen),
+	                             DefaultColormap(dpy, screen));
 	XSetLineAttributes(dpy, drw->gc, 1, LineSolid, CapButt, JoinMiter);
 
 	return drw;
@@ -37,14 +53,17 @@ drw_resize(Drw *drw, unsigned int w, unsigned int h)
 	if (drw->drawable)
 		XFreePixmap(drw->dpy, drw->drawable);
 	drw->drawable = XCreatePixmap(drw->dpy, drw->root, w, h, DefaultDepth(drw->dpy, drw->screen));
+	XftDrawChange(drw->xftdraw, drw->drawable);
 }
 
 void
 drw_free(Drw *drw)
 {
+	XftDrawDestroy(drw->xftdraw);
 	XFreePixmap(drw->dpy, drw->drawable);
 	XFreeGC(drw->dpy, drw->gc);
 	drw_fontset_free(drw->fonts);
+	free(drw->fbcache);
 	free(drw);
 }
 
@@ -111,10 +130,65 @@ xfont_free(Fnt *font)
 		return;
 	if (font->pattern)
 		FcPatternDestroy(font->pattern);
+	free(font->adv);
+	free(font->advs);
 	XftFontClose(font->dpy, font->xfont);
 	free(font);
 }
 
+static unsigned short *
+xfont_advslot(Fnt *font, FcChar32 cp)
+{
+	Adv *old;
+	unsigned int i, oldcap;
+
+	if (cp < ADVDENSE) {
+		if (!font->adv) {
+			font->adv = srealloc(NULL, ADVDENSE * sizeof(unsigned short));
+			memset(font->adv, 0xFF, ADVDENSE * sizeof(unsigned short));
+		}
+		return &font->adv[cp];
+	}
+
+	/* open addressing, a zero codepoint marks an empty slot as those
+	 * always live in the dense table */
+	if ((font->advlen + 1) * 4 > font->advcap * 3) {
+		old = font->advs, oldcap = font->advcap;
+		font->advcap = oldcap ? oldcap * 2 : 64;
+		font->advs = scalloc(font->advcap, sizeof(Adv));
+		font->advlen = 0;
+		for (i = 0; i < oldcap; i++)
+			if (old[i].cp)
+				*xfont_advslot(font, old[i].cp) = old[i].adv;
+		free(old);
+	}
+	for (i = cp * 2654435761u; font->advs[i &= font->advcap - 1].cp; i++)
+		if (font->advs[i].cp == cp)
+			return &font->advs[i].adv;
+	font->advs[i].cp = cp;
+	font->advs[i].adv = ADVNONE;
+	font->advlen++;
+	return &font->advs[i].adv;
+}
+
+/* Advance of a single codepoint, looked up from the glyph metrics once and
+ * cached in the font.  Xft does not kern, so the width of a string is the sum
+ * of the advances of its codepoints. */
+static unsigned int
+xfont_advance(Fnt *font, FcChar32 cp)
+{
+	unsigned short *adv = xfont_advslot(font, cp);
+	XGlyphInfo ext;
+	FT_UInt glyph;
+
+	if (*adv == ADVNONE) {
+		glyph = XftCharIndex(font->dpy, font->xfont, cp);
+		XftGlyphExtents(font->dpy, font->xfont, &glyph, 1, &ext);
+		*adv = MIN(MAX(ext.xOff, 0), ADVNONE - 1);
+	}
+	return *adv;
+}
+
 Fnt*
 drw_fontset_create(Drw* drw, const char *font)
 {
@@ -124,6 +198,7 @@ drw_fontset_create(Drw* drw, const char *font)
 
 	if ((fnt = xfont_create(drw, font, NULL)))
 		fnt->next = NULL;
+	memset(drw->fbcache, 0, FBCACHE * sizeof(Fbk));
 	return drw->fonts = fnt;
 }
 
@@ -142,9 +217,20 @@ drw_clr_create(Drw *drw, Clr *dest, const char *clrname)
 	if (!drw || !dest || !clrname)
 		return;
 
-	if (!XftColorAllocName(drw->dpy, DefaultVisual(drw->dpy, drw->screen),
-	                       DefaultColormap(drw->dpy, drw->screen),
-	                       clrname, dest))
+	/* hex colours are parsed here, so that on truecolor visuals none of
+	 * them costs a round trip */
+	unsigned int r, g, b;
+	XRenderColor val = { .alpha = 0xffff };
+	if (strlen(clrname) == 7 &&
+	    sscanf(clrname, "#%2x%2x%2x", &r, &g, &b) == 3) {
+		val.red = r * 0x101, val.green = g * 0x101, val.blue = b * 0x101;
+		if (!XftColorAllocValue(drw->dpy, DefaultVisual(drw->dpy, drw->screen),
+		                        DefaultColormap(drw->dpy, drw->screen),
+		                        &val, dest))
+			die("error, cannot allocate color '%s'", clrname);
+	} else if (!XftColorAllocName(drw->dpy, DefaultVisual(drw->dpy, drw->screen),
+	                              DefaultColormap(drw->dpy, drw->screen),
+	                              clrname, dest))
 		die("error, cannot allocate color '%s'", clrname);
 
 	dest->pixel |= 0xff << 24;
@@ -193,102 +279,35 @@ drw_rect(Drw *drw, int x, int y, unsigned int w, unsigned int h, int filled, int
 		XDrawRectangle(drw->dpy, drw->drawable, drw->gc, x, y, w - 1, h - 1);
 }
 
-int
-drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lpad, const char *text, int invert)
+/* Font used to draw a codepoint which the primary font lacks.  Lookups are
+ * cached per codepoint, including misses so that codepoints no font covers
+ * never reach fontconfig twice, in sets of FBWAYS picked by a hash so that
+ * codepoints a block apart do not evict each other.  At most FBFONTS fallback
+ * fonts are kept open with the least recently used one closed to make room. */
+static Fnt *
+xfont_fallback(Drw *drw, FcChar32 cp)
 {
-	char buf[1024];
-	int ty;
-	unsigned int ew;
-	XftDraw *d = NULL;
-	Fnt *usedfont, *curfont, *nextfont;
-	size_t i, len;
-	int utf8strlen, utf8charlen, render = x || y || w || h;
-	int utf8codepoint = 0;
-	const char *utf8str;
+	Fbk *set = &drw->fbcache[(cp * 2654435761u >> 24) % (FBCACHE / FBWAYS) * FBWAYS];
+	Fbk slot;
+	Fnt *font, *lru, **iter;
 	FcCharSet *fccharset;
-	FcPattern *fcpattern;
-	FcPattern *match;
+	FcPattern *fcpattern, *match;
 	XftResult result;
-	int charexists = 0;
-
-	if (!drw || (render && !drw->scheme) || !text || !drw->fonts)
-		return 0;
-
-	if (!render) {
-		w = ~w;
-	} else {
-		XSetForeground(drw->dpy, drw->gc, drw->scheme[invert ? ColFg : ColBg].pixel);
-		XFillRectangle(drw->dpy, drw->drawable, drw->gc, x, y, w, h);
-		d = XftDrawCreate(drw->dpy, drw->drawable,
-		                  DefaultVisual(drw->dpy, drw->screen),
-		                  DefaultColormap(drw->dpy, drw->screen));
-		x += lpad;
-		w -= lpad;
-	}
-
-	usedfont = drw->fonts;
-	while (1) {
-		utf8strlen = 0;
-		utf8str = text;
-		nextfont = NULL;
-		while (*text) {
-			utf8charlen = utf8decode(text, &utf8codepoint);
-			for (curfont = drw->fonts; curfont; curfont = curfont->next) {
-				charexists = charexists || XftCharExists(drw->dpy, curfont->xfont, utf8codepoint);
-				if (charexists) {
-					if (curfont == usedfont) {
-						utf8strlen += utf8charlen;
-						text += utf8charlen;
-					} else {
-						nextfont = curfont;
-					}
-					break;
-				}
-			}
-
-			if (!charexists || nextfont)
+	int i, nfont, way;
+
+	/* kept most recently used first, the last way is dropped on a miss */
+	for (way = 0; way < FBWAYS - 1 && set[way].cp != cp; way++)
+		; /* NOP */
+	slot = set[way];
+	memmove(&set[1], set, way * sizeof(Fbk));
+	if (slot.cp != cp) {
+		slot.cp = cp;
+		for (font = drw->fonts->next; font; font = font->next)
+			if (XftCharExists(drw->dpy, font->xfont, cp))
 				break;
-			else
-				charexists = 0;
-		}
-
-		if (utf8strlen) {
-			drw_font_getexts(usedfont, utf8str, utf8strlen, &ew, NULL);
-			/* shorten text if necessary */
-			for (len = MIN(utf8strlen, sizeof(buf) - 1); len && ew > w; len--)
-				drw_font_getexts(usedfont, utf8str, len, &ew, NULL);
-
-			if (len) {
-				memcpy(buf, utf8str, len);
-				buf[len] = '\0';
-				if (len < utf8strlen)
-					for (i = len; i && i > len - 3; buf[--i] = '.')
-						; /* NOP */
-
-				if (render) {
-					ty = y + (h - usedfont->h) / 2 + usedfont->xfont->ascent + 2;
-					XftDrawStringUtf8(d, &drw->scheme[invert ? ColBg : ColFg],
-					                  usedfont->xfont, x, ty, (XftChar8 *)buf, len);
-				}
-				x += ew;
-				w -= ew;
-			}
-		}
-
-		break; // TODO
-
-		if (!*text) {
-			break;
-		} else if (nextfont) {
-			charexists = 0;
-			usedfont = nextfont;
-		} else {
-			/* Regardless of whether or not a fallback font is found, the
-			 * character must be drawn. */
-			charexists = 1;
-
+		if (!font) {
 			fccharset = FcCharSetCreate();
-			FcCharSetAddChar(fccharset, utf8codepoint);
+			FcCharSetAddChar(fccharset, cp);
 
 			if (!drw->fonts->pattern) {
 				/* Refer to the comment in xfont_create for more information. */
@@ -307,22 +326,129 @@ drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lp
 			FcCharSetDestroy(fccharset);
 			FcPatternDestroy(fcpattern);
 
-			if (match) {
-				usedfont = xfont_create(drw, NULL, match);
-				if (usedfont && XftCharExists(drw->dpy, usedfont->xfont, utf8codepoint)) {
-					for (curfont = drw->fonts; curfont->next; curfont = curfont->next)
-						; /* NOP */
-					curfont->next = usedfont;
-				} else {
-					xfont_free(usedfont);
-					usedfont = drw->fonts;
-				}
+			if (match && (font = xfont_create(drw, NULL, match)) &&
+			    !XftCharExists(drw->dpy, font->xfont, cp)) {
+				xfont_free(font);
+				font = NULL;
+			}
+		}
+		if (font && !font->lru) {
+			/* newly opened, evict the least recently used fallback */
+			for (nfont = 0, lru = font->next = drw->fonts->next; lru; lru = lru->next)
+				nfont++;
+			drw->fonts->next = font;
+			if (nfont >= FBFONTS) {
+				for (lru = font->next, iter = &font->next; *iter; iter = &(*iter)->next)
+					if ((*iter)->lru < lru->lru)
+						lru = *iter;
+				for (iter = &font->next; *iter != lru; iter = &(*iter)->next)
+					; /* NOP */
+				*iter = lru->next;
+				for (i = 0; i < FBCACHE; i++)
+					if (drw->fbcache[i].font == lru)
+						drw->fbcache[i].cp = 0, drw->fbcache[i].font = NULL;
+				xfont_free(lru);
 			}
 		}
+		slot.font = font;
+	}
+	set[0] = slot;
+	if (!slot.font) /* drawn as missing by the primary font */
+		return drw->fonts;
+	slot.font->lru = ++drw->fbtick;
+	return slot.font;
+}
+
+/* Codepoint at text, strings are decoded a chunk at a time so long as each
+ * call follows on from the last. */
+static int
+utf8next(Utf8buf *dec, const char *text, wchar_t *cp)
+{
+	if (dec->pos == dec->num) {
+		dec->num = utf8decodes(text, dec->end - text, dec->cp,
+				dec->len, LENGTH(dec->cp));
+		dec->pos = 0;
+	}
+	*cp = dec->cp[dec->pos];
+	return dec->len[dec->pos++];
+}
+
+static Fnt *
+xfont_find(Drw *drw, FcChar32 cp)
+{
+	if (XftCharExists(drw->dpy, drw->fonts->xfont, cp))
+		return drw->fonts;
+	return xfont_fallback(drw, cp);
+}
+
+int
+drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lpad, const char *text, int invert)
+{
+	char buf[1024];
+	int ty;
+	unsigned int ew, cw, dw;
+	Fnt *usedfont, *nextfont = NULL;
+	size_t len, cut;
+	int utf8strlen, utf8charlen = 0, render = x || y || w || h;
+	wchar_t utf8codepoint = 0;
+	const char *utf8str, *drawstr;
+	Utf8buf dec = { .pos = 0, .num = 0 };
+
+	if (!drw || (render && !drw->scheme) || !text || !drw->fonts)
+		return 0;
+	dec.end = text + strlen(text);
+
+	if (!render) {
+		w = ~w;
+	} else {
+		XSetForeground(drw->dpy, drw->gc, drw->scheme[invert ? ColFg : ColBg].pixel);
+		XFillRectangle(drw->dpy, drw->drawable, drw->gc, x, y, w, h);
+		x += lpad;
+		w -= lpad;
 	}
-	if (d)
-		XftDrawDestroy(d);
 
+	if (*text) {
+		utf8charlen = utf8next(&dec, text, &utf8codepoint);
+		nextfont = xfont_find(drw, utf8codepoint);
+	}
+	while (*text) {
+		/* draw runs of codepoints sharing a font, ew is the width of the
+		 * run, cut the longest prefix which still fits alongside an
+		 * ellipsis and cw the width of that prefix */
+		usedfont = nextfont;
+		utf8strlen = 0;
+		utf8str = text;
+		ew = cw = cut = 0;
+		dw = 3 * xfont_advance(usedfont, '.');
+		do {
+			ew += xfont_advance(usedfont, utf8codepoint);
+			if (ew + dw <= w && utf8strlen + utf8charlen < (int)sizeof(buf) - 3)
+				cut = utf8strlen + utf8charlen, cw = ew;
+			utf8strlen += utf8charlen;
+			text += utf8charlen;
+		} while (*text && (utf8charlen = utf8next(&dec, text, &utf8codepoint),
+		         nextfont = xfont_find(drw, utf8codepoint)) == usedfont);
+
+		drawstr = utf8str;
+		len = utf8strlen;
+		if (ew > w) {
+			/* shorten text, replacing the remainder with an ellipsis */
+			memcpy(buf, utf8str, cut);
+			memcpy(&buf[cut], "...", 3);
+			drawstr = buf;
+			len = dw <= w ? cut + 3 : 0;
+			ew = len ? cw + dw : 0;
+			text = ""; /* nothing more fits */
+		}
+
+		if (len && render) {
+			ty = y + (h - usedfont->h) / 2 + usedfont->xfont->ascent + 2;
+			XftDrawStringUtf8(drw->xftdraw, &drw->scheme[invert ? ColBg : ColFg],
+			                  usedfont->xfont, x, ty, (const XftChar8 *)drawstr, len);
+		}
+		x += ew;
+		w -= ew;
+	}
 	return x + (render ? w : 0);
 }
 
@@ -347,14 +473,15 @@ drw_fontset_getwidth(Drw *drw, const char *text)
 void
 drw_font_getexts(Fnt *font, const char *text, unsigned int len, unsigned int *w, unsigned int *h)
 {
-	XGlyphInfo ext;
+	wchar_t cp;
+	const char *end = text + len;
 
 	if (!font || !text)
 		return;
 
-	XftTextExtentsUtf8(font->dpy, font->xfont, (XftChar8 *)text, len, &ext);
 	if (w)
-		*w = ext.xOff;
+		for (*w = 0; text < end; text += utf8decode(text, &cp))
+			*w += xfont_advance(font, cp);
 	if (h)
 		*h = font->h;
 }
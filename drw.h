@@ -5,14 +5,28 @@
 
 #include <X11/Xft/Xft.h>
 
+typedef struct {
+	FcChar32 cp;
+	unsigned short adv;
+} Adv;
+
 typedef struct Fnt {
 	Display *dpy;
 	unsigned int h;
 	XftFont *xfont;
 	FcPattern *pattern;
+	unsigned short *adv; /* dense advances, indexed by codepoint */
+	Adv *advs;           /* hashed advances of other codepoints */
+	unsigned int advcap, advlen;
+	unsigned long lru;   /* last use of a fallback font */
 	struct Fnt *next;
 } Fnt;
 
+typedef struct {
+	FcChar32 cp;
+	Fnt *font;           /* NULL if no font covers cp */
+} Fbk;
+
 enum { ColFg, ColBg, ColBorder }; /* Clr scheme index */
 typedef XftColor Clr;
 
@@ -22,9 +36,12 @@ typedef struct {
 	int screen;
 	Window root;
 	Drawable drawable;
+	XftDraw *xftdraw;
 	GC gc;
 	Clr *scheme;
 	Fnt *fonts;
+	Fbk *fbcache;
+	unsigned long fbtick;
 } Drw;
 
 /* Drawable abstraction */
@@ -2,6 +2,8 @@
  * Copyright (C) 2022 ArcNyxx
  * see LICENCE file for licensing information */
 
+#include <errno.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -21,7 +23,15 @@
 #include "func.h"
 #include "tile.h"
 #include "grab.h"
+#include "ipc.h"
+#include "launch.h"
+#include "path.h"
+#include "record.h"
+#include "rule.h"
+#include "snap.h"
+#include "status.h"
 #include "struct.h"
+#include "trace.h"
 #include "util.h"
 
 static int gettextprop(Window w, Atom atom, char *text, unsigned int size);
@@ -40,21 +50,20 @@ static void focusin          (XEvent *evt);
 static void keypress         (XEvent *evt);
 static void mappingnotify    (XEvent *evt);
 static void maprequest       (XEvent *evt);
-static void motionnotify     (XEvent *evt);
 static void propertynotify   (XEvent *evt);
 static void unmapnotify      (XEvent *evt);
 
 int exec = -1;
-char stext[256] = "", execa[256] = "";
+char execa[256] = "";
+char execc[256] = ""; /* completions of execa */
 bool running = true;
 
 extern Display *dpy;
 extern Monitor *sel, *mons;
 extern Window root;
-extern Drw *drw;
 extern Atom wmatom[WMLast], netatom[NetLast];
 
-extern int sw;
+extern char stext[256];
 extern Clr **scheme;
 
 static int
@@ -67,6 +76,7 @@ gettextprop(Window w, Atom atom, char *text, unsigned int size)
 	if (!text || size == 0)
 		return 0;
 	text[0] = '\0';
+	TRACETRIP();
 	if (!XGetTextProperty(dpy, w, &name, atom) || !name.nitems)
 		return 0;
 	if (name.encoding == XA_STRING)
@@ -85,11 +95,13 @@ gettextprop(Window w, Atom atom, char *text, unsigned int size)
 static void
 unmanage(Client *cli, bool dest)
 {
+	ipcevent("unmanage 0x%lx", cli->win);
 	detach(cli);
 	detachstack(cli);
 	if (!dest) {
 		XGrabServer(dpy);
 		XKillClient(dpy, cli->win);
+		TRACETRIP();
 		XSync(dpy, false);
 		XUngrabServer(dpy);
 	}
@@ -112,12 +124,16 @@ updatewmhints(Client *c)
 {
 	XWMHints *wmh;
 
+	TRACETRIP();
 	if ((wmh = XGetWMHints(dpy, c->win))) {
 		if (c == sel->sel && wmh->flags & XUrgencyHint) {
 			wmh->flags &= ~XUrgencyHint;
 			XSetWMHints(dpy, c->win, wmh);
-		} else
-			c->isurgent = (wmh->flags & XUrgencyHint) ? 1 : 0;
+		} else if (c->isurgent != ((wmh->flags & XUrgencyHint) != 0)) {
+			c->isurgent = !c->isurgent;
+			ipcevent("urgent 0x%lx %d", c->win, c->isurgent);
+			marksnap();
+		}
 		c->neverfocus = wmh->flags & InputHint ? !wmh->input : 0;
 		XFree(wmh);
 	}
@@ -128,6 +144,7 @@ updatewindowtype(Client *cli)
 {
 	unsigned long null;
 	unsigned char *ptr;
+	TRACETRIP();
 	if (XGetWindowProperty(dpy, cli->win, netatom[NetWMState], 0,
 			sizeof(Atom), false, XA_ATOM, &null, (int *)&null,
 			&null, &null, &ptr) && ptr != NULL) {
@@ -135,6 +152,7 @@ updatewindowtype(Client *cli)
 			setfullscreen(cli, true);
 		XFree(ptr);
 	}
+	TRACETRIP();
 	if (XGetWindowProperty(dpy, cli->win, netatom[NetWMWindowType], 0,
 			sizeof(Atom), false, XA_ATOM, &null, (int *)&null,
 			&null, &null, &ptr) && ptr != NULL) {
@@ -160,17 +178,9 @@ buttonpress(XEvent *evt)
 	}
 
 	if (bpe->window == sel->barwin) {
-		int i = 0, x = 0;
-		do
-			x += drw_fontset_getwidth(drw, tags[i]) + PADW;
-		while (bpe->x >= x && ++i < LENGTH(tags));
-		if (i < LENGTH(tags))
-			click = ClkTagBar, arg.n = 1 << i;
-		else if (bpe->x > sel->ww -
-				drw_fontset_getwidth(drw, stext) + PADW)
-			click = ClkStatusText;
-		else
-			click = ClkWinTitle;
+		int i;
+		if ((click = clickbar(sel, bpe->x, &i)) == ClkTagBar)
+			arg.n = 1 << i;
 	} else if ((client = wintocli(bpe->window)) != NULL) {
 		focus(client);
 		restack(sel);
@@ -220,8 +230,6 @@ configurenotify(XEvent *evt)
 	sw = evt->xconfigure.width, sh = evt->xconfigure.height;
 
 	if (updategeom() || res) {
-		drw_resize(drw, sw, PADH);
-
 		for (Monitor *mon = mons; mon != NULL; mon = mon->next) {
 			for (Client *cli = mon->clients; cli != NULL;
 					cli = cli->next)
@@ -230,6 +238,8 @@ configurenotify(XEvent *evt)
 							mon->mw, mon->mh);
 			XMoveResizeWindow(dpy, mon->barwin, mon->wx, mon->by,
 					mon->ww, PADH);
+			XMoveResizeWindow(dpy, mon->inwin, mon->mx, mon->my,
+					mon->mw, mon->mh);
 		}
 		focus(NULL);
 		tile(NULL);
@@ -275,7 +285,10 @@ configurerequest(XEvent *evt)
 		};
 		XConfigureWindow(dpy, cre->window, cre->value_mask, &wc);
 	}
+	TRACEIN(mark, dpy);
+	TRACETRIP();
 	XSync(dpy, false);
+	TRACEOUT(mark, "XSync", dpy);
 }
 
 static void
@@ -307,8 +320,12 @@ enternotify(XEvent *evt)
 static void
 expose(XEvent *evt)
 {
+	Client *cli;
 	Monitor *mon;
-	if (evt->xexpose.count == 0 &&
+	if ((cli = wintocli(evt->xexpose.window)) != NULL) {
+		if (cli->mapped != 0) /* selected only until the first */
+			exposelaunch(cli);
+	} else if (evt->xexpose.count == 0 &&
 			(mon = wintomon(evt->xexpose.window)) != NULL)
 		drawbar(mon);
 }
@@ -323,28 +340,27 @@ focusin(XEvent *evt)
 static void
 keypress(XEvent *evt)
 {
-	bool hotkey = false;
 	XKeyEvent *kpe = &evt->xkey;
-	KeySym keysym = XkbKeycodeToKeysym(dpy, kpe->keycode, 0, 0);
-	for (int i = 0; i < LENGTH(keys); ++i)
-		if (keysym == keys[i].keysym && keys[i].func != NULL &&
-				CLEAN(keys[i].mod) == CLEAN(kpe->state)) {
-			keys[i].func(keys[i].arg);
-			hotkey = true;
-		}
-	if (hotkey || exec == -1)
+	int key = keytab[kpe->keycode][KEYMOD(kpe->state)];
+	for (int i = key; i != 0; i = keynext[i - 1])
+		keys[i - 1].func(keys[i - 1].arg);
+	if (key != 0 || exec == -1)
 		return;
 
 	/* preserve uppercase keysym information */
-	keysym = XkbKeycodeToKeysym(dpy, kpe->keycode,
+	const char *path;
+	KeySym keysym = XkbKeycodeToKeysym(dpy, kpe->keycode,
 			0, (kpe->state & ShiftMask) != 0);
 	switch (keysym) {
 	case XK_Return:
-		spawn((Arg){ .v = (void *[]){ execa, NULL } });
+		path = resolvepath(execa);
+		spawn((Arg){ .v = (const void *[]){ path != NULL ? path :
+				execa, NULL } });
 	case XK_Escape: /* FALLTHROUGH */
-		exec = -1, execa[0] = '\0';
+		exec = -1, execa[0] = execc[0] = '\0';
 		grabkeys(dpy);
-		break;
+		drawbar(sel);
+		return;
 	case XK_BackSpace:
 		while (exec > 0 && (execa[--exec] & 0xC0) == 0x80);
 		execa[exec] = '\0';
@@ -354,6 +370,7 @@ keypress(XEvent *evt)
 				sizeof(execa) - exec) - 1;
 		break;
 	}
+	completepath(execa, execc, sizeof(execc));
 	drawbar(sel);
 }
 
@@ -361,8 +378,15 @@ static void
 mappingnotify(XEvent *evt)
 {
 	XRefreshKeyboardMapping(&evt->xmapping);
-	if (evt->xmapping.request == MappingKeyboard)
-		grabkeys(dpy);
+	if (evt->xmapping.request == MappingPointer)
+		return;
+
+	/* numlock may have moved, so every grab is made again */
+	getmask(dpy);
+	grabkeys(dpy);
+	for (Monitor *mon = mons; mon != NULL; mon = mon->next)
+		for (Client *cli = mon->clients; cli != NULL; cli = cli->next)
+			cli->grab = 0, grabbuttons(dpy, cli, cli == sel->sel);
 }
 
 static void
@@ -370,29 +394,34 @@ maprequest(XEvent *evt)
 {
 	static XWindowAttributes wa;
 	Window win = evt->xmaprequest.window;
-	if (!XGetWindowAttributes(dpy, win, &wa) ||
+	TRACEIN(mark, dpy);
+	TRACETRIP();
+	Status got = XGetWindowAttributes(dpy, win, &wa);
+	TRACEOUT(mark, "XGetWindowAttributes", dpy);
+	if (!got ||
 			wa.override_redirect || wintocli(win) != NULL)
 		return;
 
+	/* hidden until placed by tile, whose resize sets the border along
+	 * with the geometry */
 	Client *cli = scalloc(1, sizeof(Client));
+	cli->ishidden = 1;
 	cli->x = cli->oldx = wa.x;
 	cli->y = cli->oldy = wa.y;
 	cli->w = cli->oldw = wa.width;
 	cli->h = cli->oldh = wa.height;
 	cli->win = win;
 
-	if (!gettextprop(cli->win, netatom[NetWMName], cli->name,
-			sizeof(cli->name)))
-		gettextprop(cli->win, XA_WM_NAME, cli->name,
-				sizeof(cli->name));
+	updatetitle(cli);
 
 	Window trans;
 	Client *transc;
+	TRACETRIP();
 	if (XGetTransientForHint(dpy, win, &trans) &&
 			(transc = wintocli(trans)) != NULL)
 		cli->mon = transc->mon, cli->tags = transc->tags;
 	else
-		cli->mon = sel, cli->tags = cli->mon->tags;
+		cli->mon = sel, applyrules(cli);
 
 	if (cli->x + WIDTH(cli) > cli->mon->mx + cli->mon->mw)
 		cli->x = cli->mon->mx + cli->mon->mw - WIDTH(cli);
@@ -404,13 +433,10 @@ maprequest(XEvent *evt)
 			(cli->x + (cli->w / 2) < cli->mon->wx + cli->mon->ww))
 			? PADH : cli->mon->my);
 
-	XConfigureWindow(dpy, win, CWBorderWidth,
-			&(XWindowChanges){ .border_width = borderw });
 	XSetWindowBorder(dpy, win, scheme[ClrNorm][ColBorder].pixel);
-	configure(cli);
 	updatewindowtype(cli); updatesizehints(cli); updatewmhints(cli);
-	XSelectInput(dpy, win, EnterWindowMask | FocusChangeMask |
-			PropertyChangeMask | StructureNotifyMask);
+	XSelectInput(dpy, win, CLIMASK);
+	maplaunch(cli);
 	grabbuttons(dpy, cli, 0);
 
 	if (!cli->isfloating)
@@ -423,7 +449,6 @@ maprequest(XEvent *evt)
 
 	XChangeProperty(dpy, root, netatom[NetClientList], XA_WINDOW, 32,
 			PropModeAppend, (unsigned char *)&cli->win, 1);
-	XMoveResizeWindow(dpy, win, cli->x + 2*sw, cli->y, cli->w, cli->h);
 	XChangeProperty(dpy, win, wmatom[WMState], wmatom[WMState], 32,
 			PropModeReplace, (unsigned char *)(long[])
 			{ NormalState, 0 }, 2);
@@ -432,40 +457,29 @@ maprequest(XEvent *evt)
 		unfocus(sel->sel, 0);
 	cli->mon->sel = cli;
 	tile(cli->mon);
+	if (cli->ishidden) /* on another tag or behind a fullscreen client */
+		XMoveWindow(dpy, win, WIDTH(cli) * -2, cli->y);
 	XMapWindow(dpy, cli->win);
+	ipcevent("manage 0x%lx %d %d %s", win, monnum(cli->mon), cli->tags,
+			cli->name);
 	focus(NULL);
 }
 
-static void
-motionnotify(XEvent *evt)
-{
-	Monitor *newmon;
-	static Monitor *mon = NULL;
-
-	if (evt->xmotion.window != root)
-		return;
-	if ((newmon = rectomon(evt->xmotion.x_root, evt->xmotion.y_root,
-				1, 1)) != mon && mon != NULL) {
-		unfocus(sel->sel, 1);
-		sel = newmon;
-		focus(NULL);
-	}
-	mon = newmon;
-}
-
 static void
 propertynotify(XEvent *evt)
 {
 	Client *c;
 	XPropertyEvent *pre = &evt->xproperty;
 	if (pre->window == root && pre->atom == XA_WM_NAME) {
-		gettextprop(root, XA_WM_NAME, stext, sizeof(stext));
-		drawbars();
+		char text[sizeof(stext)];
+		gettextprop(root, XA_WM_NAME, text, sizeof(text));
+		setstatus(text);
 	} else if (pre->state != PropertyDelete &&
 			(c = wintocli(pre->window)) != NULL) {
 		Window tr;
 		if (pre->atom == XA_WM_TRANSIENT_FOR && !c->isfloating &&
-				XGetTransientForHint(dpy, c->win, &tr) &&
+				(TRACETRIP(), XGetTransientForHint(dpy, c->win,
+				&tr)) &&
 				(c->isfloating = wintocli(tr) != NULL)) {
 			tile(c->mon);
 		} else if (pre->atom == XA_WM_NORMAL_HINTS) {
@@ -476,14 +490,8 @@ propertynotify(XEvent *evt)
 		}
 
 		if (pre->atom == XA_WM_NAME ||
-				pre->atom == netatom[NetWMName]) {
-			if (!gettextprop(c->win, netatom[NetWMName], c->name,
-					sizeof(c->name)))
-				gettextprop(c->win, XA_WM_NAME, c->name,
-						sizeof(c->name));
-			if (c == c->mon->sel)
-				drawbar(c->mon);
-		}
+				pre->atom == netatom[NetWMName])
+			c->namevalid = 0; /* fetched once shown */
 		if (pre->atom == netatom[NetWMWindowType])
 			updatewindowtype(c);
 	}
@@ -520,13 +528,65 @@ handle_events(void)
 		[KeyPress]         = keypress,
 		[MappingNotify]    = mappingnotify,
 		[MapRequest]       = maprequest,
-		[MotionNotify]     = motionnotify,
 		[PropertyNotify]   = propertynotify,
 		[UnmapNotify]      = unmapnotify
 	};
+#ifdef TRACE
+	static const char *names[LASTEvent] = {
+		[ButtonPress]      = "buttonpress",
+		[ClientMessage]    = "clientmessage",
+		[ConfigureRequest] = "configurerequest",
+		[ConfigureNotify]  = "configurenotify",
+		[DestroyNotify]    = "destroynotify",
+		[EnterNotify]      = "enternotify",
+		[Expose]           = "expose",
+		[FocusIn]          = "focusin",
+		[KeyPress]         = "keypress",
+		[MappingNotify]    = "mappingnotify",
+		[MapRequest]       = "maprequest",
+		[PropertyNotify]   = "propertynotify",
+		[UnmapNotify]      = "unmapnotify"
+	};
+#endif /* TRACE */
 
 	XEvent evt;
-	while (running && !XNextEvent(dpy, &evt))
-		if (events[evt.type] != NULL)
-			events[evt.type](&evt);
+	struct pollfd fds[2 + IPCFDS] = {
+		{ .fd = ConnectionNumber(dpy), .events = POLLIN },
+		{ .fd = statusfd,              .events = POLLIN }
+	};
+	while (running) {
+		while (running && XPending(dpy)) {
+			XNextEvent(dpy, &evt);
+			recordevent(&evt);
+			if (events[evt.type] != NULL) {
+				TRACEIN(mark, dpy);
+				events[evt.type](&evt);
+				TRACEOUT(mark, names[evt.type], dpy);
+			}
+		}
+		if (!running)
+			break;
+
+		int wait = flushstatus(), next = flushtitles();
+		if (wait == -1 || (next != -1 && next < wait))
+			wait = next;
+		writesnap();
+		flushrecord();
+		pollipc(&fds[2]);
+		/* round trips made since the drain may have queued events,
+		 * which the descriptor no longer shows */
+		if (XEventsQueued(dpy, QueuedAlready) != 0)
+			wait = 0;
+		if (poll(fds, LENGTH(fds), wait) == -1 && errno != EINTR)
+			die("swim: unable to poll");
+		if (fds[1].revents & POLLIN)
+			readstatus();
+		readipc(&fds[2]);
+		if (launchdump)
+			printlaunches();
+#ifdef TRACE
+		if (tracedump)
+			printtrace();
+#endif /* TRACE */
+	}
 }
@@ -20,15 +20,17 @@
 #include "drw.h"
 #include "func.h"
 #include "grab.h"
+#include "ipc.h"
+#include "snap.h"
 #include "tile.h"
 #include "struct.h"
+#include "trace.h"
 #include "util.h"
 
 extern int sw, sh;
 extern Atom wmatom[WMLast], netatom[NetLast];
 extern Clr **scheme;
 extern Display *dpy;
-extern Drw *drw;
 extern Monitor *mons, *sel;
 extern Window root;
 
@@ -38,6 +40,7 @@ updatesizehints(Client *c)
 	long msize;
 	XSizeHints size;
 
+	TRACETRIP();
 	if (!XGetWMNormalHints(dpy, c->win, &size, &msize))
 		/* size is uninitialized, ensure that size.flags aren't used */
 		size.flags = PSize;
@@ -112,6 +115,7 @@ detachstack(Client *c)
 void
 focus(Client *c)
 {
+	TRACEIN(mark, dpy);
 	if (!c || !VISIBLE(c))
 		for (c = sel->stack; c && !VISIBLE(c); c = c->snext);
 	if (sel->sel && sel->sel != c)
@@ -132,12 +136,19 @@ focus(Client *c)
 	}
 	sel->sel = c;
 	drawbars();
+	marksnap();
+	TRACEOUT(mark, "focus", dpy);
+
+	static Window last = 0;
+	if ((c != NULL ? c->win : 0) != last)
+		ipcevent("focus 0x%lx", last = c != NULL ? c->win : 0);
 }
 
 void
 resizeclient(Client *cli, int x, int y, int w, int h)
 {
 	XWindowChanges wc = { .border_width = !cli->isfullscreen * borderw };
+	cli->ishidden = 0;
 	cli->oldx = cli->x, cli->x = wc.x = x;
 	cli->oldy = cli->y, cli->y = wc.y = y;
 	cli->oldw = cli->w, cli->w = wc.width = w;
@@ -145,7 +156,10 @@ resizeclient(Client *cli, int x, int y, int w, int h)
 	XConfigureWindow(dpy, cli->win,
 			CWX | CWY | CWWidth | CWHeight | CWBorderWidth, &wc);
 	configure(cli);
+	TRACEIN(mark, dpy);
+	TRACETRIP();
 	XSync(dpy, false);
+	TRACEOUT(mark, "XSync", dpy);
 }
 
 void
@@ -154,6 +168,7 @@ restack(Monitor *mon)
 	drawbar(mon);
 	if (mon->sel == NULL)
 		return;
+	TRACEIN(mark, dpy);
 	if (mon->sel->isfloating)
 		XRaiseWindow(dpy, mon->sel->win);
 
@@ -164,10 +179,12 @@ restack(Monitor *mon)
 					CWSibling | CWStackMode, &wc);
 			wc.sibling = cli->win;
 		}
+	TRACETRIP();
 	XSync(dpy, false);
 
 	XEvent evt;
 	while (XCheckMaskEvent(dpy, EnterWindowMask, &evt));
+	TRACEOUT(mark, "restack", dpy);
 }
 
 int
@@ -178,6 +195,7 @@ sendevent(Client *c, Atom proto)
 	int exists = 0;
 	XEvent ev;
 
+	TRACETRIP();
 	if (XGetWMProtocols(dpy, c->win, &protocols, &n)) {
 		while (!exists && n--)
 			exists = protocols[n] == proto;
@@ -207,6 +225,33 @@ setfocus(Client *c)
 	sendevent(c, wmatom[WMTakeFocus]);
 }
 
+void
+setbypass(Client *c, int bypass)
+{
+	/* ask compositors to unredirect fullscreen clients, unless the client
+	 * has a preference of its own */
+	Atom type;
+	int form;
+	unsigned long num, null;
+	unsigned char *data = NULL;
+
+	if (!bypass) {
+		if (c->ownbypass)
+			XDeleteProperty(dpy, c->win,
+					netatom[NetWMBypassCompositor]);
+		c->ownbypass = 0;
+	} else if (TRACETRIP(), XGetWindowProperty(dpy, c->win,
+			netatom[NetWMBypassCompositor], 0, 1, false,
+			XA_CARDINAL, &type, &form, &num, &null, &data) ==
+			Success && num == 0) {
+		XChangeProperty(dpy, c->win, netatom[NetWMBypassCompositor],
+				XA_CARDINAL, 32, PropModeReplace,
+				(unsigned char *)(long[]){ 1 }, 1);
+		c->ownbypass = 1;
+	}
+	XFree(data);
+}
+
 void
 setfullscreen(Client *c, int fullscreen)
 {
@@ -214,15 +259,22 @@ setfullscreen(Client *c, int fullscreen)
 		XChangeProperty(dpy, c->win, netatom[NetWMState], XA_ATOM, 32,
 			PropModeReplace, (unsigned char*)&netatom[NetWMFullscreen], 1);
 		c->isfullscreen = 1;
+		marksnap();
 		c->oldstate = c->isfloating;
 		c->isfloating = 1;
 		resizeclient(c, c->mon->mx, c->mon->my, c->mon->mw, c->mon->mh);
 		XRaiseWindow(dpy, c->win);
+		setbypass(c, 1);
+#ifdef FULLICONIC
+		tile(c->mon);
+#endif /* FULLICONIC */
 	} else if (!fullscreen && c->isfullscreen){
 		XChangeProperty(dpy, c->win, netatom[NetWMState], XA_ATOM, 32,
 			PropModeReplace, (unsigned char*)0, 0);
 		c->isfullscreen = 0;
+		marksnap();
 		c->isfloating = c->oldstate;
+		setbypass(c, 0);
 		c->x = c->oldx;
 		c->y = c->oldy;
 		c->w = c->oldw;
@@ -237,7 +289,10 @@ seturgent(Client *c, int urg)
 {
 	XWMHints *wmh;
 
+	if (c->isurgent != urg)
+		ipcevent("urgent 0x%lx %d", c->win, urg), marksnap();
 	c->isurgent = urg;
+	TRACETRIP();
 	if (!(wmh = XGetWMHints(dpy, c->win)))
 		return;
 	wmh->flags = urg ? (wmh->flags | XUrgencyHint) : (wmh->flags & ~XUrgencyHint);
@@ -258,6 +313,32 @@ unfocus(Client *c, int setfocus)
 	}
 }
 
+int
+flushtitles(void)
+{
+	/* only the titles of selected clients are shown, others are left
+	 * stale until selected unless subscribers are told of every one */
+	long long now = monotime(), wake = -1;
+	bool all = ipcwatched();
+	for (Monitor *mon = mons; mon != NULL; mon = mon->next)
+		for (Client *cli = all ? mon->clients : mon->sel; cli != NULL;
+				cli = all ? cli->next : NULL) {
+			if (cli->namevalid)
+				continue;
+			if (now - cli->namelast >= 1000000000LL / TITLERATE) {
+				updatetitle(cli);
+				if (cli == mon->sel)
+					drawbar(mon);
+			} else if (wake == -1 || cli->namelast +
+					1000000000LL / TITLERATE < wake) {
+				wake = cli->namelast + 1000000000LL /
+						TITLERATE;
+			}
+		}
+	/* milliseconds until due, rounded up */
+	return wake == -1 ? -1 : (wake - now + 999999) / 1000000;
+}
+
 void
 updatebarpos(Monitor *m)
 {
@@ -281,6 +362,7 @@ updategeom(void)
 	bool res = false; /* resizing necessary */
 
 #ifdef XINERAMA
+	TRACETRIP();
 	if (!XineramaIsActive(dpy)) {
 #endif /* XINERAMA */
 		if (mons->mw != sw || mons->mh != sh) {
@@ -294,6 +376,7 @@ updategeom(void)
 
 	int num = 0, new, i;
 	for (mon = mons; mon != NULL; mon = mon->next, ++num);
+	TRACETRIP();
 	XineramaScreenInfo *inf = XineramaQueryScreens(dpy, &new);
 
 	if (new == 0)
@@ -355,6 +438,8 @@ updategeom(void)
 
 		XUnmapWindow(dpy, mon->barwin);
 		XDestroyWindow(dpy, mon->barwin);
+		freebar(mon->bar);
+		XDestroyWindow(dpy, mon->inwin);
 		free(mon);
 	}
 
@@ -376,9 +461,87 @@ end: ;
 					CWEventMask, &wa);
 			XMapRaised(dpy, mon->barwin);
 			XSetClassHint(dpy, mon->barwin, &ch);
+			mon->bar = newbar();
 		}
 
-	if (res)
+	/* the pointer crossing onto a monitor is seen as it entering the
+	 * input window below every client, rather than by following motion */
+	XSetWindowAttributes iwa = { .override_redirect = true,
+			.event_mask = EnterWindowMask };
+	for (mon = mons; mon != NULL; mon = mon->next)
+		if (mon->inwin == 0) {
+			mon->inwin = XCreateWindow(dpy, root, mon->mx, mon->my,
+					mon->mw, mon->mh, 0, 0, InputOnly,
+					CopyFromParent, CWOverrideRedirect |
+					CWEventMask, &iwa);
+			XLowerWindow(dpy, mon->inwin);
+			XMapWindow(dpy, mon->inwin);
+		}
+
+	if (res) {
 		sel = mons, sel = wintomon(root);
+		ipcevent("monitors %d", monnum(NULL));
+	}
 	return res;
 }
+
+void
+updatetitle(Client *cli)
+{
+	Atom type;
+	int form;
+	unsigned long num, null;
+	unsigned char *data = NULL;
+	size_t len = 0;
+	char old[sizeof(cli->name)];
+
+	strcpy(old, cli->name);
+	TRACEIN(mark, dpy);
+	cli->namevalid = 1, cli->namelast = monotime();
+	cli->name[0] = '\0';
+	/* a single read of the utf8 name without locale conversion, falling
+	 * back to the icccm name */
+	TRACETRIP();
+	if (XGetWindowProperty(dpy, cli->win, netatom[NetWMName], 0,
+			sizeof(cli->name) / 4, false, wmatom[WMUTF8], &type,
+			&form, &num, &null, &data) != Success || num == 0) {
+		XFree(data), data = NULL;
+		TRACETRIP();
+		if (XGetWindowProperty(dpy, cli->win, XA_WM_NAME, 0,
+				sizeof(cli->name) / 4, false, AnyPropertyType,
+				&type, &form, &num, &null, &data) != Success ||
+				data == NULL)
+			goto done;
+	}
+
+	if (type == XA_STRING) { /* latin-1 */
+		for (unsigned long i = 0; i < num && len <
+				sizeof(cli->name) - 2; ++i) {
+			if (data[i] >= 0x80)
+				cli->name[len++] = 0xC0 | data[i] >> 6,
+						data[i] = 0x80 | (data[i] & 0x3F);
+			cli->name[len++] = data[i];
+		}
+	} else if (type == wmatom[WMUTF8]) {
+		memcpy(cli->name, data, len = MIN(num, sizeof(cli->name) - 1));
+		if (len < num) /* cut at a character boundary */
+			while (len > 0 && (data[len] & 0xC0) == 0x80)
+				--len;
+	} else {
+		char **list;
+		int cnt;
+		XTextProperty prop = { data, type, form, num };
+		if (XmbTextPropertyToTextList(dpy, &prop, &list, &cnt) >=
+				Success && cnt > 0 && *list != NULL) {
+			strncpy(cli->name, *list, sizeof(cli->name) - 1);
+			len = strlen(cli->name);
+			XFreeStringList(list);
+		}
+	}
+	cli->name[len] = '\0';
+	XFree(data);
+done: /* new clients are announced whole when managed */
+	TRACEOUT(mark, "updatetitle", dpy);
+	if (cli->mon != NULL && strcmp(old, cli->name) != 0)
+		ipcevent("title 0x%lx %s", cli->win, cli->name);
+}
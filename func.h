@@ -18,12 +18,15 @@ void focus(Client *c);
 void resizeclient(Client *c, int x, int y, int w, int h);
 void restack(Monitor *m);
 int sendevent(Client *c, Atom proto);
+void setbypass(Client *c, int bypass);
 void setfocus(Client *c);
 void setfullscreen(Client *c, int fullscreen);
 void seturgent(Client *c, int urg);
 void unfocus(Client *c, int setfocus);
 void updatebarpos(Monitor *m);
+int flushtitles(void);
 bool updategeom(void);
 void updatesizehints(Client *c);
+void updatetitle(Client *c);
 
 #endif /* FUNC_H */
@@ -2,8 +2,8 @@
  * Copyright (C) 2022 ArcNyxx
  * see LICENCE file for licensing information */
 
-#include <X11/X.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
@@ -13,11 +13,11 @@
 #include "struct.h"
 #include "util.h"
 
-static void getmask(Display *dpy);
-
 unsigned int numlock;
+unsigned short keytab[256][128];
+unsigned short keynext[LENGTH(keys)];
 
-static void
+void
 getmask(Display *dpy)
 {
 	numlock = 0;
@@ -33,14 +33,27 @@ getmask(Display *dpy)
 void
 grabbuttons(Display *dpy, Client *client, int focused)
 {
-	getmask(dpy);
-	XUngrabButton(dpy, AnyButton, AnyModifier, client->win);
-	unsigned int mods[] = { 0, LockMask, numlock, LockMask | numlock };
+	/* grabs only change with focus, a grab of zero forces them */
+	if (client->grab == (focused ? GrabFocus : GrabUnfocus))
+		return;
+	int grab = client->grab;
+	client->grab = focused ? GrabFocus : GrabUnfocus;
 
-	if (!focused)
+	/* the server keeps the button grabs apart from the AnyButton grab,
+	 * and buttonpress handles a click taken by either, so losing focus
+	 * only adds the AnyButton grab, which can only be released with
+	 * every other one */
+	if (!focused) {
+		if (grab == 0)
+			XUngrabButton(dpy, AnyButton, AnyModifier, client->win);
 		XGrabButton(dpy, AnyButton, AnyModifier, client->win, 0,
 				ButtonPressMask | ButtonReleaseMask,
 				GrabModeSync, GrabModeSync, 0, 0);
+		return;
+	}
+
+	XUngrabButton(dpy, AnyButton, AnyModifier, client->win);
+	unsigned int mods[] = { 0, LockMask, numlock, LockMask | numlock };
 	for (int i = 0; i < LENGTH(buttons); ++i) {
 		if (buttons[i].click != ClkClientWin)
 			continue;
@@ -57,14 +70,19 @@ grabkeys(Display *dpy)
 {
 	Window root = RootWindow(dpy, DefaultScreen(dpy));
 
-	getmask(dpy);
 	XUngrabKey(dpy, AnyKey, AnyModifier, root);
 	unsigned int mods[] = { 0, LockMask, numlock, LockMask | numlock };
 
+	/* bindings sharing a keycode and modifiers are chained in order */
 	KeyCode code;
-	for (int i = 0; i < LENGTH(keys); ++i) {
+	memset(keytab, 0, sizeof(keytab));
+	for (int i = LENGTH(keys) - 1; i >= 0; --i) {
 		if ((code = XKeysymToKeycode(dpy, keys[i].keysym)) == 0)
 			continue;
+		if (keys[i].func != NULL) {
+			keynext[i] = keytab[code][KEYMOD(keys[i].mod)];
+			keytab[code][KEYMOD(keys[i].mod)] = i + 1;
+		}
 		for (int j = 0; j < LENGTH(mods); ++j)
 			XGrabKey(dpy, code, keys[i].mod | mods[j], root,
 					true, GrabModeAsync, GrabModeAsync);
@@ -9,8 +9,16 @@
 
 #include "struct.h"
 
+/* index of a cleaned modifier state, lock removed to fit seven bits */
+#define KEYMOD(mask) ((CLEAN(mask) & ShiftMask) | CLEAN(mask) >> 2 << 1)
+
 extern unsigned int numlock;
+/* bound key plus one for each keycode and modifier index, or zero, with
+ * further bindings of the same keys found through keynext */
+extern unsigned short keytab[256][128];
+extern unsigned short keynext[];
 
+void getmask(Display *dpy);
 void grabbuttons(Display *dpy, Client *client, int focused);
 void grabkeys(Display *dpy);
 
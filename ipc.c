@@ -0,0 +1,329 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#define _GNU_SOURCE /* accept4 */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <X11/Xlib.h>
+
+#include "act.h"
+#include "config.h"
+#include "conv.h"
+#include "ipc.h"
+#include "struct.h"
+#include "tile.h"
+#include "util.h"
+
+#define MSGSIZE 8192 /* largest message in either direction */
+#define QUEUE   64   /* event records held for each subscriber */
+#define RECSIZE 320
+#define VERSION 1    /* of the event record format */
+
+typedef struct {
+	const char *name;
+	void (*func)(const Arg);
+	int arg; /* none, a number or a command line */
+} Command;
+
+typedef struct {
+	bool on;
+	int head, len;
+	long dropped; /* records lost since the queue was last full */
+	char recs[QUEUE][RECSIZE];
+} Sub;
+
+enum { ArgNone, ArgNum, ArgLine };
+
+static void drop(int conn);
+static bool flush(int conn);
+static void push(Sub *sub, const char *rec);
+static bool query(const char *name, char *buf, size_t size, size_t *len);
+static bool run(int conn);
+
+static const Command cmds[] = {
+	{ "focusmon",   focusmon,   ArgNum },
+	{ "focusstack", focusstack, ArgNum },
+	{ "incnmaster", incnmaster, ArgNum },
+	{ "killclient", killclient, ArgNone },
+	{ "quit",       quit,       ArgNone },
+	{ "setmfact",   setmfact,   ArgNum },
+	{ "spawn",      spawn,      ArgLine },
+	{ "tag",        tag,        ArgNum },
+	{ "tagmon",     tagmon,     ArgNum },
+	{ "togglebar",  togglebar,  ArgNone },
+	{ "togglegaps", togglegaps, ArgNone },
+	{ "toggletag",  toggletag,  ArgNum },
+	{ "toggleview", toggleview, ArgNum },
+	{ "view",       view,       ArgNum },
+	{ "zoom",       zoom,       ArgNone },
+};
+
+static int lfd = -1, conns[IPCCONNS];
+static Sub subs[IPCCONNS];
+static int nsubs;
+
+extern Monitor *mons, *sel;
+
+static void
+drop(int conn)
+{
+	close(conns[conn]), conns[conn] = -1;
+	nsubs -= subs[conn].on;
+	subs[conn].on = false, subs[conn].len = subs[conn].dropped = 0;
+}
+
+/* sends queued records until the socket would block */
+static bool
+flush(int conn)
+{
+	Sub *sub = &subs[conn];
+	for (; sub->len != 0; sub->head = (sub->head + 1) % QUEUE, --sub->len)
+		if (send(conns[conn], sub->recs[sub->head],
+				strlen(sub->recs[sub->head]),
+				MSG_DONTWAIT | MSG_NOSIGNAL) == -1)
+			return errno == EAGAIN;
+	return true;
+}
+
+static void
+push(Sub *sub, const char *rec)
+{
+	/* a slow subscriber loses records rather than holding up the wm, and
+	 * is told how many before the next record that fits */
+	if (sub->len + (sub->dropped != 0) >= QUEUE) {
+		++sub->dropped;
+		return;
+	}
+	if (sub->dropped != 0) {
+		snprintf(sub->recs[(sub->head + sub->len++) % QUEUE], RECSIZE,
+				"%d overflow %ld\n", VERSION, sub->dropped);
+		sub->dropped = 0;
+	}
+	strcpy(sub->recs[(sub->head + sub->len++) % QUEUE], rec);
+}
+
+/* appends the answer to a query to buf, returning whether name is one, as
+ * the answer may be empty */
+static bool
+query(const char *name, char *buf, size_t size, size_t *len)
+{
+	if (strcmp(name, "monitors") != 0 && strcmp(name, "tags") != 0 &&
+			strcmp(name, "clients") != 0)
+		return false;
+	for (Monitor *mon = mons; mon != NULL && *len < size;
+			mon = mon->next) {
+		if (strcmp(name, "monitors") == 0) {
+			*len += snprintf(&buf[*len], size - *len, "monitor %d %d "
+					"%d %d %d %d %d %d\n", monnum(mon),
+					mon->mx, mon->my, mon->mw, mon->mh,
+					mon->tags, mon == sel, mon->showbar);
+		} else if (strcmp(name, "tags") == 0) {
+			int occ = 0, urg = 0;
+			for (Client *cli = mon->clients; cli != NULL;
+					cli = cli->next)
+				occ |= cli->tags, urg |= cli->isurgent ?
+						cli->tags : 0;
+			*len += snprintf(&buf[*len], size - *len, "tags %d %d "
+					"%d %d\n", monnum(mon), mon->tags, occ,
+					urg);
+		} else if (strcmp(name, "clients") == 0) {
+			for (Client *cli = mon->clients; cli != NULL &&
+					*len < size; cli = cli->next)
+				*len += snprintf(&buf[*len], size - *len,
+						"client 0x%lx %d %d %d %d %d "
+						"%d %d %d %d %s\n", cli->win,
+						monnum(mon), cli->tags, cli->x,
+						cli->y, cli->w, cli->h,
+						cli->isfloating,
+						cli->isfullscreen,
+						cli == mon->sel, cli->name);
+		}
+	}
+	*len = MIN(*len, size);
+	return true;
+}
+
+/* runs each line of one message, retiling once after the last, and
+ * returns whether the connection is still open */
+static bool
+run(int conn)
+{
+	int fd = conns[conn];
+	char msg[MSGSIZE], out[MSGSIZE];
+	ssize_t num;
+	size_t len = 0;
+	bool failed = false;
+
+	if ((num = recv(fd, msg, sizeof(msg) - 1, MSG_DONTWAIT)) <= 0)
+		return num == -1 && errno == EAGAIN;
+	msg[num] = '\0';
+
+	holdtile();
+	for (char *save, *line = strtok_r(msg, "\n", &save); line != NULL;
+			line = strtok_r(NULL, "\n", &save)) {
+		char *name = line, *arg = strpbrk(line, " \t");
+		if (arg != NULL)
+			*arg++ = '\0';
+
+		if (strcmp(name, "subscribe") == 0) {
+			nsubs += !subs[conn].on, subs[conn].on = true;
+			continue;
+		}
+		if (query(name, out, sizeof(out), &len))
+			continue;
+
+		int i;
+		for (i = 0; i < LENGTH(cmds) && strcmp(name, cmds[i].name)
+				!= 0; ++i);
+		char *end = NULL, *argv[32];
+		Arg val = { 0 };
+		if (i != LENGTH(cmds) && cmds[i].arg == ArgNum && arg != NULL)
+			val.n = strtol(arg, &end, 0);
+		if (i != LENGTH(cmds) && cmds[i].arg == ArgLine && arg != NULL) {
+			int argc = 0;
+			for (char *asave, *word = strtok_r(arg, " \t", &asave);
+					word != NULL && argc < LENGTH(argv) - 1;
+					word = strtok_r(NULL, " \t", &asave))
+				argv[argc++] = word;
+			argv[argc] = NULL;
+			val.v = argc != 0 ? argv : NULL;
+		}
+
+		if (i == LENGTH(cmds) || (cmds[i].arg == ArgNum && (end == NULL
+				|| end == arg || *end != '\0')) ||
+				(cmds[i].arg == ArgLine && val.v == NULL)) {
+			failed = true;
+			len += snprintf(&out[len], sizeof(out) - len,
+					"error %s\n", name);
+			len = MIN(len, sizeof(out));
+			continue;
+		}
+		cmds[i].func(val);
+	}
+	releasetile();
+
+	if (!failed && len < sizeof(out))
+		len += snprintf(&out[len], sizeof(out) - len, "ok\n");
+	send(fd, out, MIN(len, sizeof(out) - 1), MSG_DONTWAIT | MSG_NOSIGNAL);
+	return true;
+}
+
+/* the command line running func with arg, if it can be sent over ipc */
+bool
+ipccommand(void (*func)(const Arg), const Arg arg, char *buf, size_t size)
+{
+	for (int i = 0; i < LENGTH(cmds); ++i)
+		if (cmds[i].func == func && cmds[i].arg != ArgLine) {
+			if (cmds[i].arg == ArgNum)
+				snprintf(buf, size, "%s %ld", cmds[i].name,
+						arg.n);
+			else
+				snprintf(buf, size, "%s", cmds[i].name);
+			return true;
+		}
+	return false;
+}
+
+void
+closeipc(void)
+{
+	if (lfd != -1)
+		unlink(ipcsocket);
+}
+
+void
+ipcevent(const char *fmt, ...)
+{
+	if (nsubs == 0)
+		return;
+
+	char rec[RECSIZE];
+	va_list list;
+	int len = snprintf(rec, sizeof(rec), "%d ", VERSION);
+	va_start(list, fmt);
+	len += vsnprintf(&rec[len], sizeof(rec) - len - 1, fmt, list);
+	va_end(list);
+	strcpy(&rec[MIN(len, RECSIZE - 2)], "\n");
+
+	for (int i = 0; i < IPCCONNS; ++i)
+		if (subs[i].on)
+			push(&subs[i], rec);
+}
+
+bool
+ipcwatched(void)
+{
+	return nsubs != 0;
+}
+
+void
+openipc(void)
+{
+	for (int i = 0; i < IPCCONNS; ++i)
+		conns[i] = -1;
+	if (ipcsocket == NULL)
+		return;
+
+	/* a message is delivered whole, so one holds a batch of commands */
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	if (strlen(ipcsocket) >= sizeof(addr.sun_path))
+		die("swim: ipc socket path too long\n");
+	strcpy(addr.sun_path, ipcsocket);
+	unlink(ipcsocket);
+
+	mode_t mask = umask(0077);
+	if ((lfd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK |
+			SOCK_CLOEXEC, 0)) == -1 || bind(lfd,
+			(struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+			listen(lfd, IPCCONNS) == -1)
+		die("swim: unable to open ipc socket");
+	umask(mask);
+}
+
+void
+pollipc(struct pollfd *fds)
+{
+	fds[0] = (struct pollfd){ .fd = lfd, .events = POLLIN };
+	for (int i = 0; i < IPCCONNS; ++i)
+		fds[i + 1] = (struct pollfd){ .fd = conns[i], .events =
+				POLLIN | (subs[i].len != 0 ? POLLOUT : 0) };
+}
+
+void
+readipc(const struct pollfd *fds)
+{
+	for (int i = 0; i < IPCCONNS; ++i) {
+		if (conns[i] == -1 || fds[i + 1].fd != conns[i])
+			continue;
+		if (((fds[i + 1].revents & POLLIN) && !run(i)) ||
+				((fds[i + 1].revents & POLLOUT) && !flush(i)) ||
+				(fds[i + 1].revents & (POLLHUP | POLLERR)))
+			drop(i);
+	}
+
+	/* new connections are refused while every slot is in use */
+	int fd;
+	if ((fds[0].revents & POLLIN) == 0)
+		return;
+	for (int i = 0; i < IPCCONNS; ++i)
+		if (conns[i] == -1) {
+			if ((fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK |
+					SOCK_CLOEXEC)) != -1)
+				conns[i] = fd;
+			return;
+		}
+	if ((fd = accept4(lfd, NULL, NULL, SOCK_CLOEXEC)) != -1)
+		close(fd);
+}
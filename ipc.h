@@ -0,0 +1,26 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef IPC_H
+#define IPC_H
+
+#include <poll.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "struct.h"
+
+#define IPCCONNS 8 /* connections served at once */
+#define IPCFDS   (IPCCONNS + 1)
+
+void closeipc(void);
+bool ipccommand(void (*func)(const Arg), const Arg arg, char *buf,
+		size_t size);
+void ipcevent(const char *fmt, ...);
+bool ipcwatched(void);
+void openipc(void);
+void pollipc(struct pollfd *fds);
+void readipc(const struct pollfd *fds);
+
+#endif /* IPC_H */
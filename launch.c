@@ -0,0 +1,176 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+
+#include "launch.h"
+#include "struct.h"
+#include "trace.h"
+#include "util.h"
+
+#define PENDING 32 /* launches awaiting a window */
+#define CMDS    32 /* commands with statistics */
+#define DEPTH   8  /* ancestors walked from a window's process */
+#define EXPIRE  60000000000LL /* launches never mapped are dropped */
+
+typedef struct {
+	pid_t pid;
+	int cmd;
+	long long time;
+} Launch;
+
+typedef struct {
+	long long num, sum, min, max;
+} Stat;
+
+typedef struct {
+	char name[32];
+	Stat map, expose; /* launch to map, map to first expose */
+} Cmd;
+
+static pid_t getppidof(pid_t pid);
+static void record(Stat *stat, long long val);
+
+volatile sig_atomic_t launchdump = 0;
+
+static Launch pending[PENDING];
+static Cmd cmds[CMDS];
+static int ncmds;
+
+extern Display *dpy;
+extern Atom netatom[NetLast];
+
+static pid_t
+getppidof(pid_t pid)
+{
+	char buf[512], *paren;
+	int fd, ppid = 0;
+	ssize_t len;
+
+	snprintf(buf, sizeof(buf), "/proc/%d/stat", (int)pid);
+	if ((fd = open(buf, O_RDONLY | O_CLOEXEC)) == -1)
+		return 0;
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0)
+		return 0;
+
+	/* the name in parentheses may itself contain them */
+	buf[len] = '\0';
+	if ((paren = strrchr(buf, ')')) == NULL ||
+			sscanf(paren, ") %*c %d", &ppid) != 1)
+		return 0;
+	return ppid;
+}
+
+static void
+record(Stat *stat, long long val)
+{
+	if (stat->num == 0 || val < stat->min)
+		stat->min = val;
+	if (val > stat->max)
+		stat->max = val;
+	++stat->num, stat->sum += val;
+}
+
+void
+addlaunch(pid_t pid, const char *cmd)
+{
+	const char *base = strrchr(cmd, '/');
+	base = base != NULL ? base + 1 : cmd;
+
+	int i;
+	for (i = 0; i < ncmds && strcmp(cmds[i].name, base) != 0; ++i);
+	if (i == ncmds) {
+		if (ncmds == CMDS)
+			return;
+		snprintf(cmds[ncmds++].name, sizeof(cmds[i].name), "%s", base);
+	}
+
+	/* the oldest launch makes way if every slot is taken */
+	int slot = 0;
+	for (int j = 1; j < PENDING && pending[slot].pid != 0; ++j)
+		if (pending[j].pid == 0 || pending[j].time < pending[slot].time)
+			slot = j;
+	pending[slot] = (Launch){ pid, i, monotime() };
+}
+
+void
+exposelaunch(Client *cli)
+{
+	record(&cmds[cli->launch].expose, monotime() - cli->mapped);
+	cli->mapped = 0;
+	XSelectInput(dpy, cli->win, CLIMASK);
+}
+
+void
+maplaunch(Client *cli)
+{
+	Atom type;
+	int form;
+	unsigned long num, left;
+	unsigned char *data = NULL;
+	pid_t pid = 0;
+
+	long long now = monotime();
+	int live = 0;
+	for (int i = 0; i < PENDING; ++i)
+		if (pending[i].pid != 0 && now - pending[i].time > EXPIRE)
+			pending[i].pid = 0;
+		else
+			live += pending[i].pid != 0;
+	if (live == 0)
+		return;
+
+	TRACETRIP();
+	if (XGetWindowProperty(dpy, cli->win, netatom[NetWMPid], 0, 1, false,
+			XA_CARDINAL, &type, &form, &num, &left,
+			&data) == Success && num != 0)
+		pid = *(long *)data;
+	XFree(data);
+
+	/* the launched process may have started the one owning the window */
+	for (int depth = 0; pid > 1 && depth < DEPTH; ++depth,
+			pid = getppidof(pid)) {
+		for (int i = 0; i < PENDING; ++i) {
+			if (pending[i].pid != pid)
+				continue;
+			record(&cmds[pending[i].cmd].map, now - pending[i].time);
+			pending[i].pid = 0;
+
+			/* the first expose is seen by also selecting for it */
+			cli->launch = pending[i].cmd, cli->mapped = now;
+			XSelectInput(dpy, cli->win, CLIMASK | ExposureMask);
+			return;
+		}
+	}
+}
+
+void
+printlaunches(void)
+{
+	launchdump = 0;
+	fprintf(stderr, "swim: %-16s %6s %10s %10s %10s %10s\n", "command",
+			"count", "map avg", "map max", "expose avg",
+			"expose max");
+	for (int i = 0; i < ncmds; ++i) {
+		const Stat *map = &cmds[i].map, *exp = &cmds[i].expose;
+		if (map->num == 0)
+			continue;
+		fprintf(stderr, "swim: %-16s %6lld %8.1fms %8.1fms "
+				"%8.1fms %8.1fms\n", cmds[i].name, map->num,
+				map->sum / 1e6 / map->num, map->max / 1e6,
+				exp->num != 0 ? exp->sum / 1e6 / exp->num : 0.0,
+				exp->max / 1e6);
+	}
+}
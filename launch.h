@@ -0,0 +1,20 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <signal.h>
+#include <sys/types.h>
+
+#include "struct.h"
+
+extern volatile sig_atomic_t launchdump;
+
+void addlaunch(pid_t pid, const char *cmd);
+void exposelaunch(Client *cli);
+void maplaunch(Client *cli);
+void printlaunches(void);
+
+#endif /* LAUNCH_H */
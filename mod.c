@@ -0,0 +1,98 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mod.h"
+#include "util.h"
+
+static char *readfd(int fd, char *buf, size_t size);
+
+/* whole file from the start, files are kept open and reread */
+static char *
+readfd(int fd, char *buf, size_t size)
+{
+	ssize_t len;
+	if (fd == -1 || (len = pread(fd, buf, size - 1, 0)) <= 0)
+		return NULL;
+	buf[len] = '\0';
+	return buf;
+}
+
+void
+modbattery(char *buf, size_t size, int fd, long long *prev, const char *fmt)
+{
+	char data[16];
+	if (readfd(fd, data, sizeof(data)) != NULL)
+		snprintf(buf, size, fmt, atoll(data));
+}
+
+void
+modclock(char *buf, size_t size, int fd, long long *prev, const char *fmt)
+{
+	time_t now = time(NULL);
+	struct tm tm;
+	if (localtime_r(&now, &tm) == NULL || strftime(buf, size, fmt, &tm) == 0)
+		buf[0] = '\0';
+}
+
+void
+modcpu(char *buf, size_t size, int fd, long long *prev, const char *fmt)
+{
+	/* busy percentage since the last read, the first line is the sum of
+	 * every cpu and the fourth and fifth fields are idle time */
+	char data[256];
+	long long val, tot = 0, idle = 0;
+	if (readfd(fd, data, sizeof(data)) == NULL ||
+			strncmp(data, "cpu ", 4) != 0)
+		return;
+	char *ptr = &data[4], *end;
+	for (int i = 0; (val = strtoll(ptr, &end, 10)), end != ptr;
+			++i, ptr = end) {
+		tot += val;
+		if (i == 3 || i == 4)
+			idle += val;
+	}
+
+	if (prev[0] != 0 && tot != prev[0])
+		snprintf(buf, size, fmt, 100 - (idle - prev[1]) * 100 /
+				(tot - prev[0]));
+	prev[0] = tot, prev[1] = idle;
+}
+
+void
+modmem(char *buf, size_t size, int fd, long long *prev, const char *fmt)
+{
+	/* used percentage, which excludes memory available for reclaim */
+	char data[512], *tot, *avail;
+	if (readfd(fd, data, sizeof(data)) == NULL ||
+			(tot = strstr(data, "MemTotal:")) == NULL ||
+			(avail = strstr(data, "MemAvailable:")) == NULL)
+		return;
+
+	long long totkb = atoll(tot + sizeof("MemTotal:") - 1);
+	long long availkb = atoll(avail + sizeof("MemAvailable:") - 1);
+	if (totkb != 0)
+		snprintf(buf, size, fmt, (totkb - availkb) * 100 / totkb);
+}
+
+void
+modnet(char *buf, size_t size, int fd, long long *prev, const char *fmt)
+{
+	/* kibibytes per second of a byte counter since the last read */
+	char data[32];
+	long long now = monotime();
+	if (readfd(fd, data, sizeof(data)) == NULL)
+		return;
+
+	long long bytes = atoll(data);
+	if (prev[1] != 0 && now != prev[1])
+		snprintf(buf, size, fmt, (bytes - prev[0]) * 1000000000LL /
+				(now - prev[1]) / 1024);
+	prev[0] = bytes, prev[1] = now;
+}
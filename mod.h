@@ -0,0 +1,21 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef MOD_H
+#define MOD_H
+
+#include <stddef.h>
+
+void modbattery (char *buf, size_t size, int fd, long long *prev,
+		const char *fmt);
+void modclock   (char *buf, size_t size, int fd, long long *prev,
+		const char *fmt);
+void modcpu     (char *buf, size_t size, int fd, long long *prev,
+		const char *fmt);
+void modmem     (char *buf, size_t size, int fd, long long *prev,
+		const char *fmt);
+void modnet     (char *buf, size_t size, int fd, long long *prev,
+		const char *fmt);
+
+#endif /* MOD_H */
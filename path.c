@@ -0,0 +1,307 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "path.h"
+#include "util.h"
+
+#define DIRS  64 /* directories of $PATH indexed */
+#define SHOWN 5  /* completions shown in the bar */
+
+typedef struct {
+	char *path;
+	const char *name; /* within path */
+	int dir;
+	unsigned int uses;
+} Exe;
+
+typedef struct {
+	Exe *exes;
+	int len;
+} Index;
+
+static void add(Index *idx, char *path, int dir, unsigned int uses);
+static bool better(const Exe *exe, int sc, const Exe *than, int thansc);
+static int cmpexe(const void *one, const void *two);
+static int cmpname(const void *one, const void *two);
+static bool load(Index *idx);
+static int rank(Index *idx, const char *text, int *top);
+static void *scan(void *null);
+static int score(const char *name, const char *text);
+static void store(const Index *idx);
+
+static Index *pathidx; /* published once scanned, then main thread only */
+static char cache[PATH_MAX];
+static char *dirs[DIRS];
+static long long mtimes[DIRS];
+static int ndirs;
+static bool dirty;
+
+/* matches of the last text, which only narrow as text is appended */
+static int *cand, ncand;
+static char last[256];
+static bool lastvalid;
+
+static void
+add(Index *idx, char *path, int dir, unsigned int uses)
+{
+	if (idx->len % 256 == 0)
+		idx->exes = srealloc(idx->exes, (idx->len + 256) *
+				sizeof(Exe));
+	idx->exes[idx->len++] = (Exe){ path, strrchr(path, '/') + 1,
+			dir, uses };
+}
+
+static bool
+better(const Exe *exe, int sc, const Exe *than, int thansc)
+{
+	if (sc != thansc)
+		return sc > thansc;
+	if (exe->uses != than->uses)
+		return exe->uses > than->uses;
+	return strlen(exe->name) < strlen(than->name);
+}
+
+static int
+cmpexe(const void *one, const void *two)
+{
+	const Exe *exe1 = one, *exe2 = two;
+	int cmp = strcmp(exe1->name, exe2->name);
+	return cmp != 0 ? cmp : exe1->dir - exe2->dir;
+}
+
+/* names are unique once shadowed ones are dropped, and cached entries do
+ * not keep the directory they were found in */
+static int
+cmpname(const void *one, const void *two)
+{
+	const Exe *exe1 = one, *exe2 = two;
+	return strcmp(exe1->name, exe2->name);
+}
+
+/* reads the cache, returning whether it was made from the same $PATH with
+ * unchanged directories */
+static bool
+load(Index *idx)
+{
+	FILE *file;
+	if (cache[0] == '\0' || (file = fopen(cache, "r")) == NULL)
+		return false;
+
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int dir = 0, off;
+	long long num;
+	bool match = true;
+	while ((len = getline(&line, &size, file)) > 0) {
+		if (line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (sscanf(line, "d %lld %n", &num, &off) == 1) {
+			match = match && dir < ndirs && num == mtimes[dir] &&
+					strcmp(&line[off], dirs[dir]) == 0;
+			++dir;
+		} else if (sscanf(line, "e %lld %n", &num, &off) == 1 &&
+				line[off] == '/') {
+			char *path = scalloc(len - off + 1, 1);
+			memcpy(path, &line[off], len - off);
+			add(idx, path, 0, num);
+		}
+	}
+	free(line);
+	fclose(file);
+	return match && dir == ndirs;
+}
+
+static int
+rank(Index *idx, const char *text, int *top)
+{
+	if (!lastvalid || strncmp(text, last, strlen(last)) != 0)
+		for (ncand = 0; ncand < idx->len; ++ncand)
+			cand[ncand] = ncand;
+
+	int keep = 0, ntop = 0, sc, topsc[SHOWN];
+	for (int i = 0; i < ncand; ++i) {
+		const Exe *exe = &idx->exes[cand[i]];
+		if ((sc = score(exe->name, text)) == 0)
+			continue;
+		cand[keep++] = cand[i];
+
+		/* insertion into the few best seen so far */
+		int pos = ntop;
+		while (pos > 0 && better(exe, sc, &idx->exes[top[pos - 1]],
+				topsc[pos - 1]))
+			--pos;
+		if (pos == SHOWN)
+			continue;
+		ntop -= ntop == SHOWN;
+		memmove(&top[pos + 1], &top[pos], (ntop - pos) * sizeof(int));
+		memmove(&topsc[pos + 1], &topsc[pos], (ntop - pos) *
+				sizeof(int));
+		top[pos] = cand[i], topsc[pos] = sc, ++ntop;
+	}
+	ncand = keep;
+	snprintf(last, sizeof(last), "%s", text);
+	lastvalid = true;
+	return ntop;
+}
+
+static void *
+scan(void *null)
+{
+	struct stat st;
+	for (int i = 0; i < ndirs; ++i)
+		mtimes[i] = stat(dirs[i], &st) == -1 ? -1 : st.st_mtim.tv_sec *
+				1000000000LL + st.st_mtim.tv_nsec;
+
+	Index *idx = scalloc(1, sizeof(Index)), old = { NULL, 0 };
+	if (load(&old)) {
+		*idx = old;
+		qsort(idx->exes, idx->len, sizeof(Exe), cmpexe);
+		goto publish;
+	}
+
+	for (int i = 0; i < ndirs; ++i) {
+		DIR *dir;
+		struct dirent *ent;
+		if ((dir = opendir(dirs[i])) == NULL)
+			continue;
+		while ((ent = readdir(dir)) != NULL) {
+			if (ent->d_name[0] == '.')
+				continue;
+			size_t len = strlen(dirs[i]) + strlen(ent->d_name) + 2;
+			char *path = scalloc(len, 1);
+			snprintf(path, len, "%s/%s", dirs[i], ent->d_name);
+			if (stat(path, &st) == 0 && S_ISREG(st.st_mode) &&
+					access(path, X_OK) == 0)
+				add(idx, path, i, 0);
+			else
+				free(path);
+		}
+		closedir(dir);
+	}
+
+	/* names earlier in $PATH shadow later ones, as with execvp */
+	qsort(idx->exes, idx->len, sizeof(Exe), cmpexe);
+	int len = 0;
+	for (int i = 0; i < idx->len; ++i) {
+		if (len != 0 && strcmp(idx->exes[len - 1].name,
+				idx->exes[i].name) == 0)
+			free(idx->exes[i].path);
+		else
+			idx->exes[len++] = idx->exes[i];
+	}
+	idx->len = len;
+
+	/* use counts survive a rescan */
+	for (int i = 0; i < old.len; ++i) {
+		Exe *exe = bsearch(&old.exes[i], idx->exes, idx->len,
+				sizeof(Exe), cmpname);
+		if (exe != NULL)
+			exe->uses = old.exes[i].uses;
+		free(old.exes[i].path);
+	}
+	free(old.exes);
+	store(idx);
+
+publish:
+	cand = scalloc(idx->len + 1, sizeof(int));
+	__atomic_store_n(&pathidx, idx, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/* three for the whole name, two for a prefix and one for a subsequence */
+static int
+score(const char *name, const char *text)
+{
+	size_t len = strlen(text);
+	if (strncmp(name, text, len) == 0)
+		return name[len] == '\0' ? 3 : 2;
+	for (; *name != '\0' && *text != '\0'; ++name)
+		if (*name == *text)
+			++text;
+	return *text == '\0';
+}
+
+static void
+store(const Index *idx)
+{
+	FILE *file;
+	if (cache[0] == '\0' || (file = fopen(cache, "w")) == NULL)
+		return;
+	for (int i = 0; i < ndirs; ++i)
+		fprintf(file, "d %lld %s\n", mtimes[i], dirs[i]);
+	for (int i = 0; i < idx->len; ++i)
+		fprintf(file, "e %u %s\n", idx->exes[i].uses,
+				idx->exes[i].path);
+	fclose(file);
+}
+
+void
+completepath(const char *text, char *buf, size_t size)
+{
+	Index *idx = __atomic_load_n(&pathidx, __ATOMIC_ACQUIRE);
+	int top[SHOWN], ntop;
+	buf[0] = '\0';
+	if (idx == NULL || (ntop = rank(idx, text, top)) == 0)
+		return;
+
+	size_t len = 0;
+	for (int i = 0; i < ntop && len < size; ++i)
+		len += snprintf(&buf[len], size - len, "%s%s", i != 0 ?
+				" " : "", idx->exes[top[i]].name);
+}
+
+const char *
+resolvepath(const char *text)
+{
+	Index *idx = __atomic_load_n(&pathidx, __ATOMIC_ACQUIRE);
+	int top[SHOWN];
+	if (idx == NULL || text[0] == '\0' || rank(idx, text, top) == 0)
+		return NULL;
+	++idx->exes[top[0]].uses, dirty = true;
+	return idx->exes[top[0]].path;
+}
+
+void
+savepath(void)
+{
+	Index *idx = __atomic_load_n(&pathidx, __ATOMIC_ACQUIRE);
+	if (idx != NULL && dirty)
+		store(idx);
+}
+
+void
+startpath(void)
+{
+	const char *env;
+	if ((env = getenv("XDG_CACHE_HOME")) != NULL && env[0] != '\0')
+		snprintf(cache, sizeof(cache), "%s/swim-path", env);
+	else if ((env = getenv("HOME")) != NULL)
+		snprintf(cache, sizeof(cache), "%s/.cache/swim-path", env);
+
+	if ((env = getenv("PATH")) == NULL)
+		env = "/usr/local/bin:/usr/bin:/bin";
+	char *path = scalloc(strlen(env) + 1, 1), *save;
+	strcpy(path, env);
+	for (char *dir = strtok_r(path, ":", &save); dir != NULL &&
+			ndirs < DIRS; dir = strtok_r(NULL, ":", &save))
+		dirs[ndirs++] = dir;
+
+	/* the scan stats every file on $PATH, so it is kept off the loop */
+	pthread_t thread;
+	if ((errno = pthread_create(&thread, NULL, scan, NULL)) != 0)
+		die("swim: unable to create path thread");
+	pthread_detach(thread);
+}
@@ -0,0 +1,15 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef PATH_H
+#define PATH_H
+
+#include <stddef.h>
+
+void completepath(const char *text, char *buf, size_t size);
+const char *resolvepath(const char *text);
+void savepath(void);
+void startpath(void);
+
+#endif /* PATH_H */
@@ -0,0 +1,298 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+
+#include "act.h"
+#include "config.h"
+#include "conv.h"
+#include "grab.h"
+#include "ipc.h"
+#include "record.h"
+#include "struct.h"
+#include "swimrec.h"
+#include "util.h"
+
+typedef struct {
+	Atom atom;
+	char *name;
+} Name;
+
+static const char *atomname(Atom atom);
+static void learn(Atom atom, char *name);
+static void learnall(const Atom *atoms, unsigned long num);
+static Name *nameslot(Atom atom);
+static void put(SwimRec *rec, const void *data);
+static void putprop(Window win, Atom prop);
+static bool wanted(Atom prop);
+
+static FILE *file;
+static long long last;
+static Atom props[9]; /* those swim reads from clients */
+static Name *names; /* atoms last as long as the server, so are named once */
+static int nnames, namesize = 64; /* a power of two */
+
+extern Display *dpy;
+extern Window root;
+extern Atom wmatom[WMLast], netatom[NetLast];
+extern int sw, sh;
+
+static const char *
+atomname(Atom atom)
+{
+	char *name;
+	if (nameslot(atom)->atom == None &&
+			(name = XGetAtomName(dpy, atom)) != NULL)
+		learn(atom, name);
+	return nameslot(atom)->name;
+}
+
+static void
+learn(Atom atom, char *name)
+{
+	Name *slot = nameslot(atom), *old = names;
+	if (slot->atom != None) {
+		XFree(name);
+		return;
+	}
+	*slot = (Name){ atom, name };
+	if (++nnames * 2 <= namesize)
+		return;
+	names = scalloc(namesize *= 2, sizeof(Name));
+	for (int i = 0; i < namesize / 2; ++i)
+		if (old[i].atom != None)
+			*nameslot(old[i].atom) = old[i];
+	free(old);
+}
+
+/* names those not yet known in one round trip */
+static void
+learnall(const Atom *atoms, unsigned long num)
+{
+	Atom *miss = scalloc(num + 1, sizeof(Atom));
+	char **got = scalloc(num + 1, sizeof(char *));
+	int nmiss = 0;
+	for (unsigned long i = 0; i < num; ++i)
+		if (atoms[i] != None && nameslot(atoms[i])->atom == None)
+			miss[nmiss++] = atoms[i];
+	/* those that fail are left null */
+	if (nmiss != 0)
+		XGetAtomNames(dpy, miss, nmiss, got);
+	for (int i = 0; i < nmiss; ++i)
+		if (got[i] != NULL)
+			learn(miss[i], got[i]);
+	free(miss), free(got);
+}
+
+static Name *
+nameslot(Atom atom)
+{
+	unsigned int i = atom & (namesize - 1);
+	while (names[i].atom != None && names[i].atom != atom)
+		i = (i + 1) & (namesize - 1);
+	return &names[i];
+}
+
+static void
+put(SwimRec *rec, const void *data)
+{
+	long long now = monotime();
+	rec->delay = MIN((now - last) / 1000, UINT32_MAX), last = now;
+	fwrite(rec, sizeof(SwimRec), 1, file);
+	if (rec->len != 0)
+		fwrite(data, 1, rec->len, file);
+}
+
+/* the value as it is now, which replays the change that was notified */
+static void
+putprop(Window win, Atom prop)
+{
+	Atom type;
+	int form;
+	unsigned long num, left;
+	unsigned char *val = NULL;
+	char data[SWIMREC_DATA];
+	const char *name, *tname = NULL;
+	SwimRec rec = { .type = SwimRecProp, .win = win == root ? 0 : win };
+
+	if (XGetWindowProperty(dpy, win, prop, 0, SWIMREC_DATA / 8, false,
+			AnyPropertyType, &type, &form, &num, &left, &val) !=
+			Success || (name = atomname(prop)) == NULL)
+		goto done;
+	if (type != None)
+		tname = atomname(type);
+	size_t len = snprintf(data, sizeof(data), "%s%c%s", name, '\0',
+			tname != NULL ? tname : "") + 1;
+	if (len >= sizeof(data) / 2)
+		goto done;
+
+	rec.aux = type != None ? form : 0;
+	if (type == XA_ATOM) {
+		learnall((Atom *)val, num);
+		for (unsigned long i = 0; i < num; ++i) {
+			const char *atom = ((Atom *)val)[i] != None ?
+					atomname(((Atom *)val)[i]) : NULL;
+			size_t add = atom != NULL ? strlen(atom) + 1 : 0;
+			if (add != 0 && len + add <= sizeof(data))
+				memcpy(&data[len], atom, add), len += add;
+		}
+	} else if (form == 32) {
+		for (unsigned long i = 0; i < num && len + 4 <= sizeof(data);
+				++i, len += 4)
+			memcpy(&data[len], &(uint32_t){ ((long *)val)[i] }, 4);
+	} else if (type != None) {
+		size_t size = MIN(num * form / 8, sizeof(data) - len);
+		memcpy(&data[len], val, size), len += size;
+	}
+	rec.len = len;
+	put(&rec, data);
+done:
+	XFree(val);
+}
+
+static bool
+wanted(Atom prop)
+{
+	for (int i = 0; i < LENGTH(props); ++i)
+		if (props[i] == prop)
+			return true;
+	return false;
+}
+
+void
+closerecord(void)
+{
+	if (file == NULL)
+		return;
+	fclose(file);
+	for (int i = 0; i < namesize; ++i)
+		XFree(names[i].name);
+	free(names);
+}
+
+void
+flushrecord(void)
+{
+	if (file != NULL)
+		fflush(file);
+}
+
+void
+openrecord(const char *path)
+{
+	if (path == NULL)
+		return;
+	if ((file = fopen(path, "w")) == NULL)
+		die("swim: unable to open recording");
+	SwimRecHead head = { SWIMREC_MAGIC, SWIMREC_VERSION, SWIMREC_ORDER,
+			sw, sh };
+	fwrite(&head, sizeof(head), 1, file);
+	last = monotime();
+	names = scalloc(namesize, sizeof(Name));
+
+	Atom list[LENGTH(props)] = { XA_WM_CLASS, XA_WM_NAME, XA_WM_HINTS,
+			XA_WM_NORMAL_HINTS, XA_WM_TRANSIENT_FOR,
+			wmatom[WMProtocols], netatom[NetWMName],
+			netatom[NetWMState], netatom[NetWMWindowType] };
+	memcpy(props, list, sizeof(props));
+}
+
+/* records what a stand in client would do to cause the event, which costs
+ * round trips to read window state, so timings differ while recording */
+void
+recordevent(const XEvent *evt)
+{
+	if (file == NULL)
+		return;
+
+	Window win = evt->xany.window;
+	SwimRec rec = { .win = win };
+	XWindowAttributes wa;
+	switch (evt->type) {
+	case MapRequest:
+		win = rec.win = evt->xmaprequest.window;
+		if (!XGetWindowAttributes(dpy, win, &wa) ||
+				wa.override_redirect || wintocli(win) != NULL)
+			return;
+		for (int i = 0; i < LENGTH(props); ++i)
+			putprop(win, props[i]);
+		rec.type = SwimRecMap, rec.x = wa.x, rec.y = wa.y;
+		rec.w = wa.width, rec.h = wa.height;
+		break;
+	case UnmapNotify:
+		if (evt->xunmap.send_event || wintocli(evt->xunmap.window) ==
+				NULL)
+			return;
+		rec.type = SwimRecUnmap, rec.win = evt->xunmap.window;
+		break;
+	case DestroyNotify:
+		if (wintocli(evt->xdestroywindow.window) == NULL)
+			return;
+		rec.type = SwimRecDestroy, rec.win =
+				evt->xdestroywindow.window;
+		break;
+	case ConfigureRequest:
+		rec.type = SwimRecConfigure;
+		rec.win = evt->xconfigurerequest.window;
+		rec.x = evt->xconfigurerequest.x;
+		rec.y = evt->xconfigurerequest.y;
+		rec.w = evt->xconfigurerequest.width;
+		rec.h = evt->xconfigurerequest.height;
+		rec.aux = evt->xconfigurerequest.value_mask & (CWX | CWY |
+				CWWidth | CWHeight);
+		break;
+	case PropertyNotify:
+		if (win == root ? evt->xproperty.atom == XA_WM_NAME :
+				wanted(evt->xproperty.atom) &&
+				wintocli(win) != NULL)
+			putprop(win, evt->xproperty.atom);
+		return;
+	case ClientMessage:
+		if (wintocli(win) == NULL)
+			return;
+		if (evt->xclient.message_type == netatom[NetWMState] &&
+				(evt->xclient.data.l[1] ==
+				(long)netatom[NetWMFullscreen] ||
+				evt->xclient.data.l[2] ==
+				(long)netatom[NetWMFullscreen]))
+			rec.type = SwimRecState, rec.aux =
+					evt->xclient.data.l[0];
+		else if (evt->xclient.message_type ==
+				netatom[NetActiveWindow])
+			rec.type = SwimRecActive;
+		else
+			return;
+		break;
+	case EnterNotify:
+		if (evt->xcrossing.mode != NotifyNormal)
+			return;
+		rec.type = SwimRecPointer, rec.win = 0;
+		rec.x = evt->xcrossing.x_root, rec.y = evt->xcrossing.y_root;
+		break;
+	case KeyPress: ;
+		/* bindings are replayed as the ipc commands they run, those
+		 * acting outside of the wm are left to other records */
+		char line[64];
+		int key = keytab[evt->xkey.keycode][KEYMOD(evt->xkey.state)];
+		rec.type = SwimRecCommand, rec.win = 0;
+		for (int i = key; i != 0; i = keynext[i - 1])
+			if (keys[i - 1].func != killclient && keys[i - 1].func
+					!= quit && ipccommand(keys[i - 1].func,
+					keys[i - 1].arg, line, sizeof(line))) {
+				rec.len = strlen(line);
+				put(&rec, line);
+			}
+		return;
+	default:
+		return;
+	}
+	put(&rec, NULL);
+}
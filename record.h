@@ -0,0 +1,15 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <X11/Xlib.h>
+
+void closerecord(void);
+void flushrecord(void);
+void openrecord(const char *path);
+void recordevent(const XEvent *evt);
+
+#endif /* RECORD_H */
@@ -0,0 +1,166 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include "config.h"
+#include "rule.h"
+#include "struct.h"
+#include "trace.h"
+#include "util.h"
+
+#define SLOTS (2 * LENGTH(rules) + 1) /* hash slots, always some empty */
+
+static uint32_t hash(const char *class, const char *instance);
+static bool matches(const Rule *rule, const char *class,
+		const char *instance, Atom type, const char *title);
+static void probe(const char *class, const char *instance, bool *hit);
+
+/* rules matching only on class and instance are hashed on them, those which
+ * match on title or type are tested one by one */
+static int table[SLOTS]; /* rule index plus one, zero if empty */
+static int fallback[LENGTH(rules)], nfallback;
+static Atom types[LENGTH(rules)];
+static bool fetchtype;
+
+extern Display *dpy;
+extern Monitor *mons, *sel;
+extern Atom netatom[NetLast];
+
+static uint32_t
+hash(const char *class, const char *instance)
+{
+	/* fnv-1a, absent strings are distinct from empty ones */
+	uint32_t val = 2166136261u;
+	for (const char *str = class; str != NULL && *str != '\0'; ++str)
+		val = (val ^ (unsigned char)*str) * 16777619u;
+	val = (val ^ (class != NULL ? 0x100 : 0x200)) * 16777619u;
+	for (const char *str = instance; str != NULL && *str != '\0'; ++str)
+		val = (val ^ (unsigned char)*str) * 16777619u;
+	return (val ^ (instance != NULL ? 0x100 : 0x200)) * 16777619u;
+}
+
+static bool
+matches(const Rule *rule, const char *class, const char *instance,
+		Atom type, const char *title)
+{
+	return (rule->class == NULL || strcmp(rule->class, class) == 0) &&
+		(rule->instance == NULL ||
+			strcmp(rule->instance, instance) == 0) &&
+		(rule->type == NULL || types[rule - rules] == type) &&
+		(rule->title == NULL || strstr(title, rule->title) != NULL);
+}
+
+static void
+probe(const char *class, const char *instance, bool *hit)
+{
+	for (uint32_t i = hash(class, instance); table[i %= SLOTS] != 0; ++i) {
+		const Rule *rule = &rules[table[i] - 1];
+		if ((rule->class == NULL) == (class == NULL) &&
+				(rule->instance == NULL) == (instance == NULL) &&
+				matches(rule, class, instance, None, ""))
+			hit[table[i] - 1] = true;
+	}
+}
+
+void
+applyrules(Client *cli)
+{
+	XClassHint ch = { NULL, NULL };
+	TRACETRIP();
+	XGetClassHint(dpy, cli->win, &ch);
+	const char *class = ch.res_class != NULL ? ch.res_class : "";
+	const char *instance = ch.res_name != NULL ? ch.res_name : "";
+
+	Atom type = None;
+	if (fetchtype) {
+		Atom null;
+		int form;
+		unsigned long num, left;
+		unsigned char *data = NULL;
+		TRACETRIP();
+		if (XGetWindowProperty(dpy, cli->win, netatom[NetWMWindowType],
+				0, 1, false, XA_ATOM, &null, &form, &num, &left,
+				&data) == Success && num != 0)
+			type = *(Atom *)data;
+		XFree(data);
+	}
+
+	bool hit[LENGTH(rules)] = { false };
+	probe(class, instance, hit);
+	probe(class, NULL, hit);
+	probe(NULL, instance, hit);
+	for (int i = 0; i < nfallback; ++i)
+		if (matches(&rules[fallback[i]], class, instance, type,
+				cli->name))
+			hit[fallback[i]] = true;
+
+	/* applied in the order given, later rules take precedence */
+	int mask = 0;
+	for (int i = 0; i < LENGTH(rules); ++i) {
+		if (!hit[i])
+			continue;
+		const Rule *rule = &rules[i];
+		mask |= rule->tags;
+		cli->isfloating = rule->isfloating;
+
+		Monitor *mon = mons;
+		for (int num = rule->mon; mon != NULL && num > 0; --num)
+			mon = mon->next;
+		if (rule->mon >= 0 && mon != NULL)
+			cli->mon = mon;
+
+		if (rule->w != 0 && rule->h != 0) {
+			cli->x = cli->mon->mx + rule->x;
+			cli->y = cli->mon->my + rule->y;
+			cli->w = rule->w, cli->h = rule->h;
+		}
+	}
+	cli->tags = mask & TAG ? mask & TAG : cli->mon->tags;
+
+	if (ch.res_class != NULL)
+		XFree(ch.res_class);
+	if (ch.res_name != NULL)
+		XFree(ch.res_name);
+}
+
+void
+compilerules(void)
+{
+	/* type atoms are interned together in one round trip */
+	char *names[LENGTH(rules)];
+	int which[LENGTH(rules)], num = 0;
+	Atom atoms[LENGTH(rules)];
+
+	for (int i = 0; i < LENGTH(rules); ++i) {
+		if (rules[i].type != NULL) {
+			names[num] = scalloc(strlen(rules[i].type) + 1, 1);
+			strcpy(names[num], rules[i].type);
+			which[num++] = i;
+		}
+		if (rules[i].title != NULL || rules[i].type != NULL ||
+				(rules[i].class == NULL &&
+				rules[i].instance == NULL)) {
+			fallback[nfallback++] = i;
+			continue;
+		}
+
+		uint32_t slot = hash(rules[i].class, rules[i].instance);
+		while (table[slot %= SLOTS] != 0)
+			++slot;
+		table[slot] = i + 1;
+	}
+
+	if ((fetchtype = num != 0))
+		XInternAtoms(dpy, names, num, false, atoms);
+	for (int i = 0; i < num; ++i)
+		types[which[i]] = atoms[i], free(names[i]);
+}
@@ -0,0 +1,13 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef RULE_H
+#define RULE_H
+
+#include "struct.h"
+
+void applyrules(Client *cli);
+void compilerules(void);
+
+#endif /* RULE_H */
@@ -0,0 +1,98 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#define _GNU_SOURCE /* memfd_create and file seals */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <X11/Xlib.h>
+
+#include "snap.h"
+#include "struct.h"
+#include "swimsnap.h"
+#include "util.h"
+
+static SwimSnap *snap = NULL;
+static bool dirty = false;
+
+extern Display *dpy;
+extern Monitor *mons, *sel;
+extern Window root;
+extern Atom wmatom[WMLast];
+
+void
+marksnap(void)
+{
+	dirty = true;
+}
+
+void
+opensnap(void)
+{
+	/* sealed to its size so that no reader's mapping can fault */
+	int fd;
+	if ((fd = memfd_create("swim", MFD_CLOEXEC | MFD_ALLOW_SEALING)) ==
+			-1 || ftruncate(fd, sizeof(SwimSnap)) == -1 ||
+			(snap = mmap(NULL, sizeof(SwimSnap), PROT_READ |
+			PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		die("swim: unable to create snapshot");
+	fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+	snap->version = SWIMSNAP_VERSION;
+
+	/* the descriptor stays open as readers reach it through /proc */
+	char path[64];
+	int len = snprintf(path, sizeof(path), "/proc/%d/fd/%d",
+			(int)getpid(), fd);
+	XChangeProperty(dpy, root, wmatom[WMSnapshot], wmatom[WMUTF8], 8,
+			PropModeReplace, (unsigned char *)path, len);
+	dirty = true;
+}
+
+void
+writesnap(void)
+{
+	if (!dirty || snap == NULL)
+		return;
+	dirty = false;
+
+	uint32_t seq = snap->seq, nmons = 0, nclis = 0, allmons = 0;
+	uint32_t allclis = 0;
+	__atomic_store_n(&snap->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	snap->selmon = -1, snap->focus = 0;
+	/* those without room are counted, so readers can tell */
+	for (Monitor *mon = mons; mon != NULL; mon = mon->next, ++allmons) {
+		for (Client *cli = mon->clients; cli != NULL; cli = cli->next)
+			++allclis;
+		if (nmons == SWIMSNAP_MONS)
+			continue;
+		snap->mons[nmons] = (SwimSnapMon){ mon->mx, mon->my, mon->mw,
+				mon->mh, mon->wx, mon->wy, mon->ww, mon->wh,
+				mon->tags };
+		if (mon == sel)
+			snap->selmon = nmons;
+		for (Client *cli = mon->clients; cli != NULL &&
+				nclis < SWIMSNAP_CLIS; cli = cli->next)
+			snap->clis[nclis++] = (SwimSnapCli){ cli->win,
+					(cli->isfloating ? SwimSnapFloating :
+					0) | (cli->isfullscreen ?
+					SwimSnapFullscreen : 0) |
+					(cli->isurgent ? SwimSnapUrgent : 0) |
+					(cli == sel->sel ? SwimSnapFocused :
+					0), cli->tags, nmons, cli->x, cli->y,
+					cli->w, cli->h };
+		++nmons;
+	}
+	if (sel->sel != NULL)
+		snap->focus = sel->sel->win;
+	snap->nmons = nmons, snap->nclis = nclis;
+	snap->allmons = allmons, snap->allclis = allclis;
+
+	__atomic_store_n(&snap->seq, seq + 2, __ATOMIC_RELEASE);
+}
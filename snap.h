@@ -0,0 +1,12 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef SNAP_H
+#define SNAP_H
+
+void marksnap(void);
+void opensnap(void);
+void writesnap(void);
+
+#endif /* SNAP_H */
@@ -0,0 +1,83 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "swimsnap.h"
+#include "util.h"
+
+#define READS 1000000 /* reads of each case */
+#define GAP   10000   /* nanoseconds between writes, far above swim */
+
+static void publish(uint32_t nclis);
+static void *rewrite(void *null);
+
+static SwimSnap snap;
+static uint32_t clients;
+static bool writing;
+
+/* as swim writes it, every client holding the sequence it was written at */
+static void
+publish(uint32_t nclis)
+{
+	uint32_t seq = snap.seq;
+	__atomic_store_n(&snap.seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	for (uint32_t i = 0; i < nclis; ++i)
+		snap.clis[i] = (SwimSnapCli){ seq, 0, seq, 0, seq, seq, seq,
+				seq };
+	snap.nclis = snap.allclis = nclis, snap.focus = seq;
+	__atomic_store_n(&snap.seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static void *
+rewrite(void *null)
+{
+	struct timespec gap = { 0, GAP };
+	while (__atomic_load_n(&writing, __ATOMIC_RELAXED))
+		publish(clients), nanosleep(&gap, NULL);
+	return NULL;
+}
+
+int
+main(void)
+{
+	static const uint32_t sizes[] = { 10, 100, SWIMSNAP_CLIS };
+	SwimSnap out;
+	pthread_t thread;
+
+	printf("%-8s %-6s %10s\n", "clients", "writer", "ns/read");
+	for (int i = 0; i < LENGTH(sizes); ++i)
+		for (int busy = 0; busy < 2; ++busy) {
+			clients = sizes[i];
+			publish(clients);
+			writing = busy;
+			if (busy && pthread_create(&thread, NULL, rewrite,
+					NULL) != 0)
+				die("snapbench: unable to create writer\n");
+
+			/* a torn read would mix sequences */
+			long long start = monotime();
+			for (int j = 0; j < READS; ++j) {
+				swimsnap_read(&snap, &out);
+				for (uint32_t k = 0; k < out.nclis; ++k)
+					if (out.clis[k].win != out.focus)
+						die("snapbench: torn read\n");
+			}
+			long long time = monotime() - start;
+
+			if (busy) {
+				__atomic_store_n(&writing, false,
+						__ATOMIC_RELAXED);
+				pthread_join(thread, NULL);
+			}
+			printf("%-8u %-6s %10.1f\n", clients, busy ? "busy" :
+					"idle", (double)time / READS);
+			fflush(stdout);
+		}
+	return 0;
+}
@@ -0,0 +1,139 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bar.h"
+#include "config.h"
+#include "status.h"
+#include "util.h"
+
+#define INTERVAL (1000000000LL / STATUSRATE)
+#define SEP "  "
+
+static void compose(void);
+static long long runmodules(long long now);
+
+int statusfd = -1;
+char stext[256] = "";
+
+static bool pending = false;
+static char ext[sizeof(stext)], next[sizeof(stext)];
+static long long last; /* time of the last redraw */
+
+static char segs[LENGTH(modules)][64];
+static int fds[LENGTH(modules)];
+static long long prev[LENGTH(modules)][2], due[LENGTH(modules)];
+
+static void
+compose(void)
+{
+	size_t len = snprintf(next, sizeof(next), "%s", ext);
+	for (int i = 0; i < LENGTH(modules) && len < sizeof(next); ++i)
+		if (segs[i][0] != '\0')
+			len += snprintf(&next[len], sizeof(next) - len, "%s%s",
+					len != 0 ? SEP : "", segs[i]);
+	pending = true;
+}
+
+/* refreshes modules which are due, returning when the next one is */
+static long long
+runmodules(long long now)
+{
+	bool changed = false;
+	long long wake = -1;
+	for (int i = 0; i < LENGTH(modules); ++i) {
+		if (modules[i].func == NULL)
+			continue;
+		if (now >= due[i]) {
+			char seg[sizeof(segs[i])] = "";
+			modules[i].func(seg, sizeof(seg), fds[i], prev[i],
+					modules[i].fmt);
+			if (strcmp(seg, segs[i]) != 0)
+				strcpy(segs[i], seg), changed = true;
+			due[i] = now + modules[i].interval * 1000000000LL;
+		}
+		if (wake == -1 || due[i] < wake)
+			wake = due[i];
+	}
+	if (changed)
+		compose();
+	return wake;
+}
+
+int
+flushstatus(void)
+{
+	long long now = monotime(), wake = runmodules(now);
+	if (pending && now - last < INTERVAL) {
+		if (wake == -1 || last + INTERVAL < wake)
+			wake = last + INTERVAL;
+	} else if (pending) {
+		pending = false, last = now;
+		if (strcmp(stext, next) != 0) {
+			strcpy(stext, next);
+			drawstatus();
+		}
+	}
+	/* milliseconds until due, rounded up */
+	return wake == -1 ? -1 : (wake - now + 999999) / 1000000;
+}
+
+void
+openstatus(void)
+{
+	for (int i = 0; i < LENGTH(modules); ++i)
+		fds[i] = modules[i].path == NULL ? -1 :
+				open(modules[i].path, O_RDONLY | O_CLOEXEC);
+
+	if (statusfifo == NULL)
+		return;
+	if (mkfifo(statusfifo, 0600) == -1 && errno != EEXIST)
+		die("swim: unable to create status fifo");
+	/* held open for writing as well so that it never reads end of file
+	 * between producers */
+	if ((statusfd = open(statusfifo, O_RDWR | O_NONBLOCK | O_CLOEXEC)) == -1)
+		die("swim: unable to open status fifo");
+}
+
+void
+readstatus(void)
+{
+	static char buf[sizeof(stext)];
+	static size_t len = 0;
+
+	ssize_t num;
+	while ((num = read(statusfd, &buf[len], sizeof(buf) - len)) > 0) {
+		len += num;
+
+		/* only the last complete line is of any use */
+		size_t end = len, start;
+		while (end > 0 && buf[end - 1] != '\n')
+			--end;
+		if (end == 0) {
+			if (len == sizeof(buf))
+				len = 0; /* discard overlong lines */
+			continue;
+		}
+		for (start = end - 1; start > 0 && buf[start - 1] != '\n';)
+			--start;
+		buf[end - 1] = '\0';
+		setstatus(&buf[start]);
+		memmove(buf, &buf[end], len -= end);
+	}
+}
+
+void
+setstatus(const char *text)
+{
+	snprintf(ext, sizeof(ext), "%s", text);
+	compose();
+	flushstatus();
+}
@@ -0,0 +1,15 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef STATUS_H
+#define STATUS_H
+
+extern int statusfd;
+
+int flushstatus(void);
+void openstatus(void);
+void readstatus(void);
+void setstatus(const char *text);
+
+#endif /* STATUS_H */
@@ -5,26 +5,39 @@
 #ifndef STRUCT_H
 #define STRUCT_H
 
+#include <stddef.h>
+
 #include <X11/Xlib.h>
 
 enum { ClrNorm, ClrSel };
 enum { ClkTagBar, ClkStatusText, ClkWinTitle, ClkClientWin, ClkRootWin };
 enum { NetSupported, NetWMName, NetWMState, NetWMCheck, NetWMFullscreen,
 		NetActiveWindow, NetWMWindowType, NetWMWindowTypeDialog,
-		NetClientList, NetLast };
-enum { WMProtocols, WMDelete, WMState, WMTakeFocus, WMLast };
+		NetClientList, NetWMBypassCompositor, NetWMPid, NetLast };
+enum { GrabFocus = 1, GrabUnfocus };
+enum { WMProtocols, WMDelete, WMState, WMTakeFocus, WMUTF8, WMSnapshot,
+		WMLast };
 
 typedef union  arg     Arg;
+typedef struct budget  Budget;
 typedef struct button  Button;
 typedef struct key     Key;
 typedef struct client  Client;
+typedef struct module  Module;
 typedef struct monitor Monitor;
+typedef struct rule    Rule;
 
 union arg {
 	signed long n;
 	const void *v;
 };
 
+struct budget {
+	const char *name; /* of a span */
+	int reqs, trips; /* requests and round trips */
+	int perreqs, pertrips; /* added for each managed client */
+};
+
 struct button {
 	int click, mask, button;
 	void (*func)(const Arg);
@@ -38,6 +51,19 @@ struct key {
 	const Arg arg;
 };
 
+struct module {
+	void (*func)(char *buf, size_t size, int fd, long long *prev,
+			const char *fmt);
+	const char *path, *fmt;
+	int interval; /* seconds */
+};
+
+struct rule {
+	const char *class, *instance, *title, *type;
+	int tags, mon, isfloating;
+	int x, y, w, h; /* relative to the monitor, used if w and h are set */
+};
+
 struct client {
 	char name[256];
 	int tags;
@@ -50,11 +76,16 @@ struct client {
 	int oldx, oldy, oldw, oldh;
 	int basew, baseh, incw, inch, maxw, maxh, minw, minh, hintsvalid;
 	int isfixed, isfloating, isurgent, neverfocus, oldstate, isfullscreen;
+	int namevalid, isiconic, ishidden, ownbypass;
+	int grab; /* button grabs held, zero if none */
+	long long namelast; /* time the name was last fetched */
+	long long mapped; int launch; /* launch awaiting its first expose */
 	Window win;
 };
 
 struct monitor {
 	int mfact, nmaster, tags, showbar;
+	int retile; /* tiled while tiling was held */
 
 	Client *clients, *stack, *sel;
 	Monitor *next;
@@ -62,7 +93,8 @@ struct monitor {
 	int by;               /* bar geometry */
 	int mx, my, mw, mh;   /* screen size */
 	int wx, wy, ww, wh;   /* window area  */
-	Window barwin;
+	Window barwin, inwin; /* inwin reports the pointer entering */
+	int bar;              /* slot of the bar thread */
 };
 
 #endif /* STRUCT_H */
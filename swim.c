@@ -2,10 +2,12 @@
  * Copyright (C) 2022 ArcNyxx
  * see LICENCE file for licensing information */
 
+#include <fcntl.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -19,13 +21,23 @@
 #include "drw.h"
 #include "evt.h"
 #include "grab.h"
+#include "ipc.h"
+#include "launch.h"
+#include "path.h"
+#include "record.h"
+#include "snap.h"
+#include "rule.h"
+#include "status.h"
+#include "trace.h"
 #include "struct.h"
 #include "func.h"
 #include "util.h"
 
-#define ATOM(name) XInternAtom(dpy, name, false)
-
+static void sigdump(int null);
 static void sighandle(int null);
+#ifdef TRACE
+static void sigtrace(int null);
+#endif /* TRACE */
 static int xchkwm(Display *dpy, XErrorEvent *evt);
 static int xerror(Display *dpy, XErrorEvent *evt);
 
@@ -35,19 +47,34 @@ int sw, sh;
 Atom wmatom[WMLast], netatom[NetLast];
 Clr **scheme;
 Display *dpy;
-Drw *drw;
 Monitor *mons, *sel;
 Window root;
 
+static void
+sigdump(int null)
+{
+	launchdump = 1;
+}
+
 static void
 sighandle(int null)
 {
 	while (waitpid(-1, NULL, WNOHANG) > 0);
 }
 
+#ifdef TRACE
+static void
+sigtrace(int null)
+{
+	tracedump = 1;
+}
+#endif /* TRACE */
+
 static int
-xchkwm(Display *null, XErrorEvent *evt)
+xchkwm(Display *edpy, XErrorEvent *evt)
 {
+	if (edpy != dpy) /* the handler is shared with the bar thread */
+		return xerror(edpy, evt);
 	die("swim: another window manager already running\n");
 	return 1;
 }
@@ -84,71 +111,115 @@ xerror(Display *null, XErrorEvent *evt)
 }
 
 int
-main(void)
+main(int argc, char *argv[])
 {
-	if ((dpy = XOpenDisplay(NULL)) == NULL)
+	timing(NULL);
+	const char *record = NULL;
+	for (int i = 1; i < argc; ++i)
+		if (strcmp(argv[i], "--timings") == 0)
+			timings = true;
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+			record = argv[++i];
+		else if (strcmp(argv[i], "--ipc") == 0 && i + 1 < argc)
+			ipcsocket = argv[++i];
+		else
+			die("usage: swim [--timings] [--record file] "
+					"[--ipc socket]\n");
+
+	if (!XInitThreads() || (dpy = XOpenDisplay(NULL)) == NULL)
 		die("swim: unable to open display\n");
+	fcntl(ConnectionNumber(dpy), F_SETFD, FD_CLOEXEC);
+	timing("display");
 
 	root = RootWindow(dpy, DefaultScreen(dpy));
 	sw   = DisplayWidth(dpy, DefaultScreen(dpy));
 	sh   = DisplayHeight(dpy, DefaultScreen(dpy));
 
-	drw = drw_create(dpy, DefaultScreen(dpy), root, sw, sh);
-	if (!drw_fontset_create(drw, font))
-		die("swim: unable to create fonts\n");
+	/* the bar thread's connection shares the handler, so it must be set
+	 * before the thread starts */
+	xeorig = XSetErrorHandler(xerror);
+	startbar();
+	timing("bar");
 
 	struct sigaction act = { .sa_handler = sighandle };
 	sigemptyset(&act.sa_mask); sigaction(SIGCHLD, &act, NULL);
-
-	scheme = scalloc(LENGTH(colors), sizeof(Clr *));
-	for (size_t i = 0; i < LENGTH(colors); i++)
-		scheme[i] = drw_scm_create(drw, colors[i], 3);
+	act.sa_handler = sigdump; sigaction(SIGUSR1, &act, NULL);
+#ifdef TRACE
+	act.sa_handler = sigtrace; sigaction(SIGUSR2, &act, NULL);
+#endif /* TRACE */
 
 	mons = scalloc(1, sizeof(Monitor));
 	mons->tags = 1, mons->mfact = mfact, mons->nmaster = nmaster,
 			mons->showbar = showbar;
 	updategeom(); drawbars();
-
-	wmatom [WMProtocols]           = ATOM("WM_PROTOCOLS");
-	wmatom [WMDelete]              = ATOM("WM_DELETE_WINDOW");
-	wmatom [WMState]               = ATOM("WM_STATE");
-	wmatom [WMTakeFocus]           = ATOM("WM_TAKE_FOCUS");
-	netatom[NetActiveWindow]       = ATOM("_NET_ACTIVE_WINDOW");
-	netatom[NetSupported]          = ATOM("_NET_SUPPORTED");
-	netatom[NetWMName]             = ATOM("_NET_WM_NAME");
-	netatom[NetWMState]            = ATOM("_NET_WM_STATE");
-	netatom[NetWMCheck]            = ATOM("_NET_SUPPORTING_WM_CHECK");
-	netatom[NetWMFullscreen]       = ATOM("_NET_WM_STATE_FULLSCREEN");
-	netatom[NetWMWindowType]       = ATOM("_NET_WM_WINDOW_TYPE");
-	netatom[NetWMWindowTypeDialog] = ATOM("_NET_WM_WINDOW_TYPE_DIALOG");
-	netatom[NetClientList]         = ATOM("_NET_CLIENT_LIST");
+	timing("monitors");
+
+	/* every atom is interned with a single round trip */
+	static char names[WMLast + NetLast][28] = {
+		[WMProtocols]                    = "WM_PROTOCOLS",
+		[WMDelete]                       = "WM_DELETE_WINDOW",
+		[WMState]                        = "WM_STATE",
+		[WMTakeFocus]                    = "WM_TAKE_FOCUS",
+		[WMUTF8]                         = "UTF8_STRING",
+		[WMSnapshot]                     = "_SWIM_SNAPSHOT",
+		[WMLast + NetActiveWindow]       = "_NET_ACTIVE_WINDOW",
+		[WMLast + NetSupported]          = "_NET_SUPPORTED",
+		[WMLast + NetWMName]             = "_NET_WM_NAME",
+		[WMLast + NetWMState]            = "_NET_WM_STATE",
+		[WMLast + NetWMCheck]            = "_NET_SUPPORTING_WM_CHECK",
+		[WMLast + NetWMFullscreen]       = "_NET_WM_STATE_FULLSCREEN",
+		[WMLast + NetWMWindowType]       = "_NET_WM_WINDOW_TYPE",
+		[WMLast + NetWMWindowTypeDialog] = "_NET_WM_WINDOW_TYPE_DIALOG",
+		[WMLast + NetClientList]         = "_NET_CLIENT_LIST",
+		[WMLast + NetWMBypassCompositor] = "_NET_WM_BYPASS_COMPOSITOR",
+		[WMLast + NetWMPid]              = "_NET_WM_PID"
+	};
+	char *list[LENGTH(names)];
+	Atom atoms[LENGTH(names)];
+	for (int i = 0; i < LENGTH(names); ++i)
+		list[i] = names[i];
+	XInternAtoms(dpy, list, LENGTH(list), false, atoms);
+	memcpy(wmatom, atoms, sizeof(wmatom));
+	memcpy(netatom, &atoms[WMLast], sizeof(netatom));
+	timing("atoms");
 
 	Window checkwin = XCreateSimpleWindow(dpy, root, 0, 0, 1, 1, 0, 0, 0);
 	XChangeProperty(dpy, checkwin, netatom[NetWMCheck], XA_WINDOW, 32,
 			PropModeReplace, (unsigned char *)&checkwin, 1);
 	XChangeProperty(dpy, root, netatom[NetWMCheck], XA_WINDOW, 32,
 			PropModeReplace, (unsigned char *)&checkwin, 1);
-	XChangeProperty(dpy, checkwin, netatom[NetWMName], ATOM("UTF8_STRING"),
-			8, PropModeReplace, (const unsigned char *)"swim", 3);
+	XChangeProperty(dpy, checkwin, netatom[NetWMName], wmatom[WMUTF8], 8,
+			PropModeReplace, (const unsigned char *)"swim", 3);
 	XChangeProperty(dpy, root, netatom[NetSupported], XA_ATOM, 32,
 			PropModeReplace, (unsigned char *)netatom, NetLast);
 	XDeleteProperty(dpy, root, netatom[NetClientList]);
 
 	/* fail if multiple wms due to substructureredirectmask selection */
 	XSetWindowAttributes attrs = { .event_mask = ButtonPressMask |
-			EnterWindowMask | LeaveWindowMask | PointerMotionMask |
+			EnterWindowMask | LeaveWindowMask |
 			PropertyChangeMask | StructureNotifyMask |
 			SubstructureNotifyMask | SubstructureRedirectMask,
 			.cursor = XCreateFontCursor(dpy, XC_left_ptr) };
 	XChangeWindowAttributes(dpy, root, CWEventMask | CWCursor, &attrs);
-	xeorig = XSetErrorHandler(xchkwm);
+	XSetErrorHandler(xchkwm);
 	XSelectInput(dpy, root, attrs.event_mask);
 	XSync(dpy, false);
 	XSetErrorHandler(xerror);
-	XSync(dpy, false);
+	timing("root");
+	getmask(dpy);
 	grabkeys(dpy);
+	compilerules();
+	openstatus();
+	openipc();
+	opensnap();
+	openrecord(record);
+	startpath();
 
 	focus(NULL);
+	timing("events");
 	handle_events();
+	savepath();
+	closeipc();
+	closerecord();
 	XCloseDisplay(dpy);
 }
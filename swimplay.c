@@ -0,0 +1,626 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#define _GNU_SOURCE /* struct ucred */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include "swimrec.h"
+#include "util.h"
+
+#define WINS 4096 /* stand in windows alive at once */
+#define WAIT 1000000000LL /* nanoseconds for swim to act on a request */
+#define IDLE 10000000LL /* before a command is taken to have done nothing */
+#define AnyChange LASTEvent /* configure or focus of any stand in window */
+
+typedef struct {
+	uint32_t rec; /* id when recorded */
+	Window win;
+} Win;
+
+typedef struct {
+	Window win;
+	int x, y;
+	unsigned int w, h;
+	bool mapped, urgent;
+} Gen;
+
+/* operations after OpPointer are only run with the ipc socket */
+enum { OpMap, OpFullscreen, OpConfigure, OpPointer, OpRetitle, OpUrgent,
+		OpView, OpTag, OpZoom, OpFocus, OpMfact, OpLast };
+
+static bool act(const char *line, long long *time);
+static bool await(int type, Window win, long long wait);
+static int cmplat(const void *one, const void *two);
+static void command(const char *line);
+static void dump(FILE *file);
+static Gen *genwin(Window win);
+static void generate(int clients, int ops);
+static Window lookup(uint32_t rec, bool make);
+static bool next(FILE *file, SwimRec *rec, char *data);
+static void play(const SwimRec *rec, const char *data);
+static void replay(FILE *file, double speed);
+static void setprop(Window win, const SwimRec *rec, const char *data);
+static void settle(void);
+static long long swimcpu(void);
+static int xerror(Display *disp, XErrorEvent *evt);
+
+static const char *recnames[SwimRecLast] = { "map", "unmap", "destroy",
+		"configure", "prop", "state", "active", "pointer", "command" };
+static const char *opnames[OpLast] = { "map", "fullscreen", "configure",
+		"pointer", "retitle", "urgent", "view", "tag", "zoom",
+		"focusstack", "setmfact" };
+
+static Display *dpy;
+static Window root, focused;
+static Win wins[WINS];
+static Gen *gens;
+static int nwins, ngens, ipc = -1;
+static unsigned long errors, skipped;
+
+/* times a command to the first configure or focus it causes, those found to
+ * change nothing once swim has settled are not counted */
+static bool
+act(const char *line, long long *time)
+{
+	settle();
+	await(0, None, 0); /* handles what earlier operations left */
+	*time = monotime();
+	command(line);
+	if (await(AnyChange, None, IDLE))
+		return true;
+	settle();
+	return await(AnyChange, None, 0);
+}
+
+/* handles events until one of type on win arrives or wait passes */
+static bool
+await(int type, Window win, long long wait)
+{
+	long long end = monotime() + wait, left;
+	struct pollfd pfd = { .fd = ConnectionNumber(dpy), .events = POLLIN };
+	XEvent evt;
+	Gen *gen;
+	for (;;) {
+		while (XPending(dpy)) {
+			XNextEvent(dpy, &evt);
+			/* focus following the pointer over the root window */
+			if (evt.type == FocusIn && evt.xfocus.detail ==
+					NotifyPointer)
+				continue;
+			if ((gen = genwin(evt.xany.window)) == NULL)
+				continue;
+			if (evt.type == ConfigureNotify)
+				gen->x = evt.xconfigure.x, gen->y =
+						evt.xconfigure.y, gen->w =
+						evt.xconfigure.width, gen->h =
+						evt.xconfigure.height;
+			else if (evt.type == MapNotify || evt.type ==
+					UnmapNotify)
+				gen->mapped = evt.type == MapNotify;
+			else if (evt.type == FocusIn)
+				focused = gen->win;
+			if (type == AnyChange ? evt.type == ConfigureNotify ||
+					evt.type == FocusIn : evt.type == type &&
+					gen->win == win)
+				return true;
+		}
+		if ((left = end - monotime()) <= 0)
+			return false;
+		poll(&pfd, 1, (left + 999999) / 1000000);
+	}
+}
+
+static int
+cmplat(const void *one, const void *two)
+{
+	const long long *lat1 = one, *lat2 = two;
+	return (*lat1 > *lat2) - (*lat1 < *lat2);
+}
+
+static void
+command(const char *line)
+{
+	char buf[8192];
+	if (ipc == -1) {
+		++skipped;
+		return;
+	}
+	/* waiting on the reply keeps commands in order with window changes */
+	if (send(ipc, line, strlen(line), MSG_NOSIGNAL) == -1 ||
+			recv(ipc, buf, sizeof(buf), 0) <= 0)
+		die("swimplay: unable to talk to swim");
+}
+
+/* as text, one record a line, without needing a display */
+static void
+dump(FILE *file)
+{
+	SwimRec rec;
+	char data[SWIMREC_DATA + 1];
+	while (next(file, &rec, data)) {
+		printf("%u %s %#x %d %d %u %u %u", rec.delay, rec.type <
+				SwimRecLast ? recnames[rec.type] : "unknown",
+				rec.win, rec.x, rec.y, rec.w, rec.h, rec.aux);
+		if (rec.type == SwimRecCommand)
+			printf(" %s", data);
+		if (rec.type != SwimRecProp) {
+			putchar('\n');
+			continue;
+		}
+
+		const char *tname = &data[strlen(data) + 1], *val, *end;
+		val = &tname[strlen(tname) + 1], end = &data[rec.len];
+		printf(" %s %s", data, *tname != '\0' ? tname : "-");
+		if (strcmp(tname, "ATOM") == 0) {
+			for (; val < end; val += strlen(val) + 1)
+				printf(" %s", val);
+		} else if (rec.aux == 32) {
+			for (uint32_t word; val + 4 <= end; val += 4)
+				memcpy(&word, val, 4), printf(" %u", word);
+		} else if (rec.aux == 8) {
+			/* escaped so that a record stays on its line */
+			putchar(' ');
+			for (; val < end; ++val)
+				if (*val == '\n')
+					fputs("\\n", stdout);
+				else if (*val == '\\')
+					fputs("\\\\", stdout);
+				else
+					putchar(*val != '\0' ? *val : ' ');
+		}
+		putchar('\n');
+	}
+}
+
+/* xlib hands out ids in increasing order, so windows are found by search */
+static Gen *
+genwin(Window win)
+{
+	int low = 0, high = ngens - 1, mid;
+	while (low <= high) {
+		mid = (low + high) / 2;
+		if (gens[mid].win == win)
+			return &gens[mid];
+		if (gens[mid].win < win)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+	return NULL;
+}
+
+static void
+generate(int clients, int ops)
+{
+	char line[64];
+	XSetWindowAttributes wa = { .event_mask = StructureNotifyMask |
+			FocusChangeMask };
+	char class[] = "swimplay";
+	XClassHint ch = { class, class };
+	int sw = DisplayWidth(dpy, DefaultScreen(dpy));
+
+	long long start = monotime();
+	gens = scalloc(clients, sizeof(Gen));
+	while (ngens < clients) {
+		Gen *gen = &gens[ngens++];
+		gen->w = 200, gen->h = 100;
+		gen->win = XCreateWindow(dpy, root, 0, 0, gen->w, gen->h, 0,
+				CopyFromParent, InputOutput, CopyFromParent,
+				CWEventMask, &wa);
+		snprintf(line, sizeof(line), "swimplay %d", ngens - 1);
+		XStoreName(dpy, gen->win, line);
+		XSetClassHint(dpy, gen->win, &ch);
+		XMapWindow(dpy, gen->win);
+		await(MapNotify, gen->win, WAIT);
+	}
+	printf("%d clients mapped in %.3f s\n", clients,
+			(monotime() - start) / 1e9);
+
+	long long *lats[OpLast], cpu = swimcpu();
+	int nlats[OpLast] = { 0 }, misses[OpLast] = { 0 };
+	for (int op = 0; op < OpLast; ++op)
+		lats[op] = scalloc(ops, sizeof(long long));
+
+	/* each operation is timed from the request to the event showing swim
+	 * acted on it, or for those without one to the reply of the socket */
+	int done = 0;
+	for (int i = 0; i < ops; ++i) {
+		int op = rand() % (ipc != -1 ? OpLast : OpPointer + 1);
+		Gen *gen = &gens[rand() % ngens];
+		long long time = monotime();
+		bool ok = true;
+		switch (op) {
+		case OpMap:
+			if (gen->mapped) {
+				XUnmapWindow(dpy, gen->win);
+				await(UnmapNotify, gen->win, WAIT);
+			}
+			time = monotime();
+			XMapWindow(dpy, gen->win);
+			ok = await(MapNotify, gen->win, WAIT);
+			break;
+		case OpFullscreen:
+			/* swim leaves hidden clients be until they are shown */
+			if (!gen->mapped || gen->x < 0)
+				continue;
+			XEvent evt = { .xclient = { .type = ClientMessage,
+					.window = gen->win, .format = 32,
+					.message_type = XInternAtom(dpy,
+					"_NET_WM_STATE", false), .data.l = { 2,
+					(long)XInternAtom(dpy,
+					"_NET_WM_STATE_FULLSCREEN", false) } } };
+			time = monotime();
+			XSendEvent(dpy, root, false, SubstructureNotifyMask |
+					SubstructureRedirectMask, &evt);
+			ok = await(ConfigureNotify, gen->win, WAIT);
+			break;
+		case OpConfigure:
+			if (!gen->mapped)
+				continue;
+			XResizeWindow(dpy, gen->win, 100 + rand() % 500,
+					100 + rand() % 500);
+			ok = await(ConfigureNotify, gen->win, WAIT);
+			break;
+		case OpPointer:
+			/* onto a shown client without focus, if one is found */
+			for (int j = 0; j < 8 && (!gen->mapped || gen->win ==
+					focused || gen->x < 0 || gen->x >= sw);
+					++j)
+				gen = &gens[rand() % ngens];
+			if (!gen->mapped || gen->win == focused || gen->x < 0 ||
+					gen->x >= sw)
+				continue;
+			time = monotime();
+			XWarpPointer(dpy, None, root, 0, 0, 0, 0, gen->x +
+					gen->w / 2, gen->y + gen->h / 2);
+			ok = await(FocusIn, gen->win, WAIT);
+			break;
+		case OpRetitle:
+			snprintf(line, sizeof(line), "swimplay %d", i);
+			XStoreName(dpy, gen->win, line);
+			settle();
+			break;
+		case OpUrgent:
+			XSetWMHints(dpy, gen->win, &(XWMHints){ .flags =
+					(gen->urgent = !gen->urgent) ?
+					XUrgencyHint : 0 });
+			settle();
+			break;
+		case OpView: /* FALLTHROUGH */
+		case OpTag:
+			snprintf(line, sizeof(line), "%s %d", opnames[op],
+					1 << rand() % 3);
+			if (!act(line, &time))
+				continue;
+			break;
+		case OpMfact:
+			if (!act(rand() % 2 ? "setmfact 5" : "setmfact -5",
+					&time))
+				continue;
+			break;
+		default:
+			if (!act(op == OpZoom ? "zoom" : "focusstack 1", &time))
+				continue;
+			break;
+		}
+		if (ok)
+			lats[op][nlats[op]++] = monotime() - time;
+		else
+			++misses[op];
+		++done;
+	}
+
+	if (cpu != -1)
+		cpu = swimcpu() - cpu;
+	printf("%-10s %8s %10s %10s %8s\n", "operation", "count", "p50 us",
+			"p99 us", "timeouts");
+	for (int op = 0; op < OpLast; ++op) {
+		if (nlats[op] + misses[op] == 0)
+			continue;
+		qsort(lats[op], nlats[op], sizeof(long long), cmplat);
+		printf("%-10s %8d %10.1f %10.1f %8d\n", opnames[op],
+				nlats[op], nlats[op] ? lats[op][nlats[op] / 2] /
+				1e3 : 0, nlats[op] ? lats[op][nlats[op] * 99 /
+				100] / 1e3 : 0, misses[op]);
+		free(lats[op]);
+	}
+	if (cpu != -1 && done != 0)
+		printf("swim cpu %.1f us per operation\n", (double)cpu / done);
+	free(gens);
+}
+
+/* stand in windows are created on first use, unmapped until a map record */
+static Window
+lookup(uint32_t rec, bool make)
+{
+	if (rec == 0)
+		return root;
+	for (int i = 0; i < nwins; ++i)
+		if (wins[i].rec == rec)
+			return wins[i].win;
+	if (!make || nwins == WINS)
+		return None;
+	wins[nwins] = (Win){ rec, XCreateSimpleWindow(dpy, root, 0, 0, 1, 1,
+			0, 0, 0) };
+	return wins[nwins++].win;
+}
+
+static bool
+next(FILE *file, SwimRec *rec, char *data)
+{
+	if (fread(rec, sizeof(SwimRec), 1, file) != 1)
+		return false;
+	if (rec->len > SWIMREC_DATA || fread(data, 1, rec->len, file) !=
+			rec->len)
+		die("swimplay: recording is truncated\n");
+	data[rec->len] = '\0';
+	return true;
+}
+
+static void
+play(const SwimRec *rec, const char *data)
+{
+	Window win = lookup(rec->win, rec->type == SwimRecMap ||
+			rec->type == SwimRecProp);
+	XWindowChanges wc = { .x = rec->x, .y = rec->y,
+			.width = MAX(rec->w, 1), .height = MAX(rec->h, 1) };
+	XEvent evt = { .xclient = { .type = ClientMessage, .window = win,
+			.format = 32 } };
+
+	if (win == None && rec->type != SwimRecPointer &&
+			rec->type != SwimRecCommand) {
+		++skipped;
+		return;
+	}
+	switch (rec->type) {
+	case SwimRecMap:
+		XConfigureWindow(dpy, win, CWX | CWY | CWWidth | CWHeight, &wc);
+		XMapWindow(dpy, win);
+		break;
+	case SwimRecUnmap:
+		XUnmapWindow(dpy, win);
+		break;
+	case SwimRecDestroy:
+		XDestroyWindow(dpy, win);
+		for (int i = 0; i < nwins; ++i)
+			if (wins[i].win == win)
+				wins[i] = wins[--nwins];
+		break;
+	case SwimRecConfigure:
+		XConfigureWindow(dpy, win, rec->aux, &wc);
+		break;
+	case SwimRecProp:
+		setprop(win, rec, data);
+		break;
+	case SwimRecState:
+		evt.xclient.message_type = XInternAtom(dpy, "_NET_WM_STATE",
+				false);
+		evt.xclient.data.l[0] = rec->aux;
+		evt.xclient.data.l[1] = XInternAtom(dpy,
+				"_NET_WM_STATE_FULLSCREEN", false);
+		XSendEvent(dpy, root, false, SubstructureNotifyMask |
+				SubstructureRedirectMask, &evt);
+		break;
+	case SwimRecActive:
+		evt.xclient.message_type = XInternAtom(dpy,
+				"_NET_ACTIVE_WINDOW", false);
+		evt.xclient.data.l[0] = 1; /* from an application */
+		XSendEvent(dpy, root, false, SubstructureNotifyMask |
+				SubstructureRedirectMask, &evt);
+		break;
+	case SwimRecPointer:
+		XWarpPointer(dpy, None, root, 0, 0, 0, 0, rec->x, rec->y);
+		break;
+	case SwimRecCommand:
+		XSync(dpy, false);
+		command(data);
+		break;
+	default:
+		++skipped;
+		break;
+	}
+}
+
+static void
+setprop(Window win, const SwimRec *rec, const char *data)
+{
+	/* names are interned once, xlib caches them after */
+	const char *tname = &data[strlen(data) + 1], *val, *end;
+	Atom prop = XInternAtom(dpy, data, false), type;
+	if (rec->aux == 0) {
+		XDeleteProperty(dpy, win, prop);
+		return;
+	}
+	type = XInternAtom(dpy, tname, false);
+	val = &tname[strlen(tname) + 1], end = &data[rec->len];
+
+	long longs[SWIMREC_DATA / 4];
+	int num = 0;
+	if (type == XA_ATOM) {
+		for (; val < end && num < LENGTH(longs); val += strlen(val) + 1)
+			longs[num++] = XInternAtom(dpy, val, false);
+	} else if (rec->aux == 32) {
+		for (uint32_t word; val + 4 <= end && num < LENGTH(longs);
+				val += 4) {
+			memcpy(&word, val, 4);
+			longs[num++] = type == XA_WINDOW ? (long)lookup(word,
+					false) : (long)word;
+		}
+	} else if (rec->aux == 8 || rec->aux == 16) {
+		XChangeProperty(dpy, win, prop, type, rec->aux, PropModeReplace,
+				(const unsigned char *)val, (end - val) /
+				(rec->aux / 8));
+		return;
+	} else {
+		return;
+	}
+	XChangeProperty(dpy, win, prop, type, 32, PropModeReplace,
+			(unsigned char *)longs, num);
+}
+
+static void
+replay(FILE *file, double speed)
+{
+	/* delays are kept against the start so that they do not drift, a
+	 * speed of zero plays records back to back */
+	SwimRec rec;
+	char data[SWIMREC_DATA + 1];
+	unsigned long recs = 0;
+	long long start = monotime(), due = 0;
+	while (next(file, &rec, data)) {
+		due += rec.delay * 1000LL;
+		if (speed > 0 && due / speed > monotime() - start) {
+			long long at = start + due / speed;
+			struct timespec ts = { at / 1000000000LL,
+					at % 1000000000LL };
+			XFlush(dpy);
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+					&ts, NULL) != 0);
+		}
+		if (rec.type < SwimRecLast)
+			play(&rec, data), ++recs;
+	}
+	settle();
+
+	printf("%lu records in %.3f s, %lu skipped, %lu errors\n", recs,
+			(monotime() - start) / 1e9, skipped, errors);
+}
+
+/* swim reads the socket after its events, so a second reply is only sent
+ * once every event caused before the first has been handled */
+static void
+settle(void)
+{
+	XSync(dpy, false);
+	for (int i = 0; i < 2 && ipc != -1; ++i)
+		command("monitors\n");
+}
+
+/* microseconds of cpu used by swim, found as the peer of the socket */
+static long long
+swimcpu(void)
+{
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+	char buf[1024], *paren;
+	unsigned long user, sys;
+	ssize_t num;
+	int fd;
+	if (ipc == -1 || getsockopt(ipc, SOL_SOCKET, SO_PEERCRED, &cred,
+			&len) == -1)
+		return -1;
+	snprintf(buf, sizeof(buf), "/proc/%d/stat", (int)cred.pid);
+	if ((fd = open(buf, O_RDONLY | O_CLOEXEC)) == -1)
+		return -1;
+	num = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (num <= 0)
+		return -1;
+
+	buf[num] = '\0';
+	if ((paren = strrchr(buf, ')')) == NULL || sscanf(paren, ") %*c %*d "
+			"%*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &user,
+			&sys) != 2)
+		return -1;
+	return (user + sys) * 1000000LL / sysconf(_SC_CLK_TCK);
+}
+
+static int
+xerror(Display *disp, XErrorEvent *evt)
+{
+	/* windows destroyed by swim or already gone when recorded */
+	++errors;
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	double speed = 1;
+	const char *sock = NULL;
+	bool dumping = false;
+	int opt, clients = 0, ops = 1000;
+	while ((opt = getopt(argc, argv, "dg:i:n:r:s:")) != -1) {
+		if (opt == 'd')
+			dumping = true;
+		else if (opt == 'g')
+			clients = atoi(optarg);
+		else if (opt == 'i')
+			sock = optarg;
+		else if (opt == 'n')
+			ops = atoi(optarg);
+		else if (opt == 'r')
+			srand(atoi(optarg));
+		else if (opt == 's')
+			speed = strtod(optarg, NULL);
+		else
+			break;
+	}
+	if (opt != -1 || optind != argc - (clients == 0) || speed < 0 ||
+			clients < 0 || ops < 0 || (dumping && clients != 0))
+		die("usage: swimplay [-i socket] [-s speed] file\n"
+				"       swimplay -d file\n"
+				"       swimplay [-i socket] [-r seed] [-n ops] "
+				"-g clients\n");
+
+	FILE *file = NULL;
+	SwimRecHead head;
+	if (clients == 0) {
+		if ((file = fopen(argv[optind], "r")) == NULL)
+			die("swimplay: unable to open recording");
+		if (fread(&head, sizeof(head), 1, file) != 1 ||
+				memcmp(head.magic, SWIMREC_MAGIC,
+				sizeof(SWIMREC_MAGIC)) != 0)
+			die("swimplay: not a recording\n");
+		if (head.order != SWIMREC_ORDER)
+			die("swimplay: recording is of another byte order\n");
+		if (head.version != SWIMREC_VERSION)
+			die("swimplay: recording is of another version\n");
+	}
+	if (dumping) {
+		printf("%ux%u\n", head.sw, head.sh);
+		dump(file), fclose(file);
+		return 0;
+	}
+
+	if ((dpy = XOpenDisplay(NULL)) == NULL)
+		die("swimplay: unable to open display\n");
+	root = DefaultRootWindow(dpy);
+	XSetErrorHandler(xerror);
+	if (file != NULL && (DisplayWidth(dpy, DefaultScreen(dpy)) != head.sw
+			|| DisplayHeight(dpy, DefaultScreen(dpy)) != head.sh))
+		fprintf(stderr, "swimplay: recorded on a %ux%u screen\n",
+				head.sw, head.sh);
+
+	if (sock != NULL) {
+		struct sockaddr_un addr = { .sun_family = AF_UNIX };
+		snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", sock);
+		if ((ipc = socket(AF_UNIX, SOCK_SEQPACKET, 0)) == -1 ||
+				connect(ipc, (struct sockaddr *)&addr,
+				sizeof(addr)) == -1)
+			die("swimplay: unable to connect to swim");
+	}
+
+	if (file != NULL)
+		replay(file, speed), fclose(file);
+	else
+		generate(clients, ops);
+	XCloseDisplay(dpy);
+	return 0;
+}
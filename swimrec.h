@@ -0,0 +1,43 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef SWIMREC_H
+#define SWIMREC_H
+
+/* format of the event recordings written by swim --record and read by
+ * swimplay; a header is followed by records, each followed by len bytes of
+ * data, all in the byte order of the recording machine */
+
+#include <stdint.h>
+
+#define SWIMREC_MAGIC   "swimrec"
+#define SWIMREC_VERSION 1
+#define SWIMREC_ORDER   0x01020304 /* as written, to detect byte order */
+#define SWIMREC_DATA    4096       /* largest data of a record */
+
+/* win is zero for the root window; prop data holds the property and type
+ * names, each nul terminated, then the value, its format in aux with zero
+ * for a deletion; atom values are nul terminated names and others of
+ * format 32 are uint32_t; command data is an ipc command line */
+enum { SwimRecMap, SwimRecUnmap, SwimRecDestroy, SwimRecConfigure,
+		SwimRecProp, SwimRecState, SwimRecActive, SwimRecPointer,
+		SwimRecCommand, SwimRecLast };
+
+typedef struct {
+	char magic[8];
+	uint32_t version, order;
+	uint16_t sw, sh; /* screen size */
+} SwimRecHead;
+
+typedef struct {
+	uint32_t delay; /* microseconds since the previous record */
+	uint32_t win;
+	uint8_t type, pad;
+	uint16_t len;
+	int16_t x, y;
+	uint16_t w, h;
+	uint32_t aux; /* value mask, format or state action */
+} SwimRec;
+
+#endif /* SWIMREC_H */
@@ -0,0 +1,82 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef SWIMSNAP_H
+#define SWIMSNAP_H
+
+/* reader of the state swim publishes in shared memory, found at the path
+ * in the _SWIM_SNAPSHOT property of the root window; once mapped, reading
+ * makes no system calls */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define SWIMSNAP_VERSION 2
+#define SWIMSNAP_MONS    16
+#define SWIMSNAP_CLIS    256
+
+enum { SwimSnapFloating = 1, SwimSnapFullscreen = 2, SwimSnapUrgent = 4,
+		SwimSnapFocused = 8 };
+
+typedef struct {
+	int32_t x, y, w, h;     /* screen size */
+	int32_t wx, wy, ww, wh; /* window area */
+	uint32_t tags;
+} SwimSnapMon;
+
+typedef struct {
+	uint32_t win, flags, tags;
+	int32_t mon, x, y, w, h;
+} SwimSnapCli;
+
+typedef struct {
+	uint32_t seq; /* odd while swim is writing */
+	uint32_t version, nmons, nclis;
+	uint32_t allmons, allclis; /* beyond n if the arrays were too small */
+	int32_t selmon;
+	uint32_t focus;
+	SwimSnapMon mons[SWIMSNAP_MONS];
+	SwimSnapCli clis[SWIMSNAP_CLIS];
+} SwimSnap;
+
+static inline SwimSnap *
+swimsnap_open(const char *path)
+{
+	int fd;
+	void *map;
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+		return NULL;
+	map = mmap(NULL, sizeof(SwimSnap), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	return map == MAP_FAILED ? NULL : (SwimSnap *)map;
+}
+
+static inline void
+swimsnap_close(SwimSnap *snap)
+{
+	munmap(snap, sizeof(SwimSnap));
+}
+
+/* copies a consistent snapshot, retrying if swim wrote during the copy */
+static inline void
+swimsnap_read(const SwimSnap *snap, SwimSnap *out)
+{
+	uint32_t seq;
+	do {
+		while ((seq = __atomic_load_n(&snap->seq,
+				__ATOMIC_ACQUIRE)) & 1);
+		memcpy(out, snap, offsetof(SwimSnap, clis));
+		if (out->nclis > SWIMSNAP_CLIS)
+			out->nclis = SWIMSNAP_CLIS;
+		memcpy(out->clis, snap->clis, out->nclis *
+				sizeof(SwimSnapCli));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&snap->seq, __ATOMIC_RELAXED) != seq);
+}
+
+#endif /* SWIMSNAP_H */
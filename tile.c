@@ -5,18 +5,26 @@
 #include <stdbool.h>
 
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
 
 #include "config.h"
 #include "func.h"
+#include "snap.h"
 #include "struct.h"
 #include "tile.h"
+#include "trace.h"
 #include "util.h"
 
 static void arrange(Monitor *mon);
+#ifdef FULLICONIC
+static void iconify(Monitor *mon, bool iconic);
+#endif /* FULLICONIC */
+static void layout(Monitor *mon);
 static void resize(Client *cli, int x, int y, int w, int h);
 static void showhide(Client *cli);
 
 bool gap = true;
+static bool held = false;
 
 extern Display *dpy;
 extern Monitor *mons;
@@ -67,6 +75,43 @@ arrange(Monitor *mon)
 	}
 }
 
+#ifdef FULLICONIC
+static void
+iconify(Monitor *mon, bool iconic)
+{
+	/* tiled clients behind a fullscreen client are iconic until it
+	 * leaves, so that they may stop drawing */
+	extern Atom wmatom[WMLast];
+	for (Client *cli = mon->clients; cli != NULL; cli = cli->next) {
+		if (cli->isiconic == iconic || (iconic && (cli->isfloating ||
+				!VISIBLE(cli))))
+			continue;
+		cli->isiconic = iconic;
+		XChangeProperty(dpy, cli->win, wmatom[WMState], wmatom[WMState],
+				32, PropModeReplace, (unsigned char *)(long[])
+				{ iconic ? IconicState : NormalState, 0 }, 2);
+		if (iconic && !cli->ishidden)
+			XMoveWindow(dpy, cli->win, WIDTH(cli) * -2, cli->y),
+					cli->ishidden = 1;
+	}
+}
+#endif /* FULLICONIC */
+
+static void
+layout(Monitor *mon)
+{
+	bool full = nextfull(mon->clients) != NULL;
+#ifdef FULLICONIC
+	iconify(mon, full);
+#endif /* FULLICONIC */
+	showhide(mon->stack);
+	if (!full) { /* occluded clients are arranged once fullscreen ends */
+		TRACEIN(mark, dpy);
+		arrange(mon);
+		TRACEOUT(mark, "arrange", dpy);
+	}
+}
+
 static void
 resize(Client *cli, int x, int y, int w, int h)
 {
@@ -118,7 +163,8 @@ resize(Client *cli, int x, int y, int w, int h)
 		h = MIN(h, cli->maxh);
 
 skip_hints:
-	if (x != cli->x || y != cli->y || w != cli->w || h != cli->h)
+	if (cli->ishidden || x != cli->x || y != cli->y || w != cli->w ||
+			h != cli->h)
 		resizeclient(cli, x, y, w, h);
 }
 
@@ -127,17 +173,29 @@ showhide(Client *cli)
 {
 	if (cli == NULL)
 		return;
+	/* hidden tiled clients are moved back by arrange, which configures
+	 * them once with their final geometry */
 	if (VISIBLE(cli)) {
-		XMoveWindow(dpy, cli->win, cli->x, cli->y);
-		if (cli->isfloating && !cli->isfullscreen)
+		if (cli->ishidden && cli->isfloating)
+			resizeclient(cli, cli->x, cli->y, cli->w, cli->h);
+		else if (cli->isfloating && !cli->isfullscreen)
 			resize(cli, cli->x, cli->y, cli->w, cli->h);
 		showhide(cli->snext); /* show clients top down */
 	} else {
 		showhide(cli->snext); /* hide clients bottom up */
-		XMoveWindow(dpy, cli->win, WIDTH(cli) * -2, cli->y);
+		if (!cli->ishidden)
+			XMoveWindow(dpy, cli->win, WIDTH(cli) * -2, cli->y),
+					cli->ishidden = 1;
 	}
 }
 
+Client *
+nextfull(Client *cli)
+{
+	for (; cli && (!cli->isfullscreen || !VISIBLE(cli)); cli = cli->next);
+	return cli;
+}
+
 Client *
 nexttiled(Client *cli)
 {
@@ -145,17 +203,37 @@ nexttiled(Client *cli)
 	return cli;
 }
 
+void
+holdtile(void)
+{
+	held = true;
+}
+
+void
+releasetile(void)
+{
+	held = false;
+	for (Monitor *mon = mons; mon != NULL; mon = mon->next)
+		if (mon->retile)
+			mon->retile = 0, tile(mon);
+}
+
 void
 tile(Monitor *mon)
 {
+	if (held) { /* arranged once released */
+		for (Monitor *iter = mons; iter != NULL; iter = iter->next)
+			iter->retile |= mon == NULL || mon == iter;
+		return;
+	}
+	TRACEIN(mark, dpy);
 	if (mon != NULL) {
-		showhide(mon->stack);
-		arrange(mon);
+		layout(mon);
 		restack(mon);
 	} else {
-		for (mon = mons; mon != NULL; mon = mon->next) {
-			showhide(mon->stack);
-			arrange(mon);
-		}
+		for (mon = mons; mon != NULL; mon = mon->next)
+			layout(mon);
 	}
+	marksnap();
+	TRACEOUT(mark, "tile", dpy);
 }
@@ -7,7 +7,10 @@
 
 #include "struct.h"
 
+void holdtile(void);
+Client *nextfull(Client *cli);
 Client *nexttiled(Client *cli);
+void releasetile(void);
 void tile(Monitor *mon);
 
 #endif /* TILE_H */
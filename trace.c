@@ -0,0 +1,148 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include "trace.h"
+
+#ifdef TRACE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <X11/Xlib.h>
+
+#ifdef TRACEUSDT
+#include <sys/sdt.h>
+#endif /* TRACEUSDT */
+
+#include "config.h"
+#include "struct.h"
+#include "util.h"
+
+#define SPANS 8192 /* spans kept, a power of two */
+
+typedef struct {
+	unsigned long seq; /* index plus one once written, zero while being */
+	const char *name;
+	long long start, dur;
+	unsigned long reqs, trips;
+	int tid;
+} Span;
+
+static void checkbudget(const Span *span);
+
+volatile sig_atomic_t tracedump = 0;
+unsigned long tracetrips = 0;
+
+static Span ring[SPANS];
+static unsigned long head;
+
+extern Display *dpy;
+extern Monitor *mons;
+
+/* budgets grow with clients, which are only walked on the main thread */
+static void
+checkbudget(const Span *span)
+{
+	const Budget *bud = NULL;
+	for (int i = 0; i < LENGTH(budgets) && bud == NULL; ++i)
+		if (strcmp(budgets[i].name, span->name) == 0)
+			bud = &budgets[i];
+	if (bud == NULL)
+		return;
+
+	unsigned long clis = 0, reqs, trips;
+	for (Monitor *mon = mons; mon != NULL; mon = mon->next)
+		for (Client *cli = mon->clients; cli != NULL; cli = cli->next)
+			++clis;
+	reqs = bud->reqs + bud->perreqs * clis;
+	trips = bud->trips + bud->pertrips * clis;
+	if (span->reqs > reqs || span->trips > trips)
+		fprintf(stderr, "swim: %s took %lu requests and %lu round "
+				"trips, over its budget of %lu and %lu with %lu "
+				"clients\n", span->name, span->reqs, span->trips,
+				reqs, trips, clis);
+}
+
+void
+printtrace(void)
+{
+	static int dumps = 0;
+	char path[128];
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	FILE *file = NULL;
+	int fd;
+
+	tracedump = 0;
+	/* only a private directory, and never through a planted link */
+	if (dir == NULL) {
+		fputs("swim: unable to write trace without XDG_RUNTIME_DIR\n",
+				stderr);
+		return;
+	}
+	snprintf(path, sizeof(path), "%s/swim-trace-%d-%d.json", dir,
+			(int)getpid(), dumps++);
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW |
+			O_CLOEXEC, 0600)) == -1 || (file = fdopen(fd, "w")) ==
+			NULL) {
+		perror("swim: unable to write trace");
+		if (fd != -1)
+			close(fd);
+		return;
+	}
+
+	/* spans being written while dumping are left out */
+	unsigned long end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+	unsigned long i = end > SPANS ? end - SPANS : 0;
+	fprintf(file, "{\"traceEvents\":[");
+	for (const char *sep = ""; i < end; ++i) {
+		Span *slot = &ring[i % SPANS], span;
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != i + 1)
+			continue;
+		span = *slot;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != i + 1)
+			continue;
+		fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+				"\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":"
+				"{\"requests\":%lu,\"trips\":%lu}}", sep,
+				span.name, span.start / 1e3, span.dur / 1e3,
+				(int)getpid(), span.tid, span.reqs, span.trips);
+		sep = ",";
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	fprintf(stderr, "swim: trace written to %s\n", path);
+}
+
+Mark
+tracein(Display *disp)
+{
+	return (Mark){ monotime(), NextRequest(disp), disp == dpy ?
+			tracetrips : 0 };
+}
+
+void
+traceout(Mark mark, const char *name, Display *disp)
+{
+	/* a slot is claimed by one writer, so either thread may record */
+	unsigned long i = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+	Span *span = &ring[i % SPANS];
+	__atomic_store_n(&span->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	span->name = name, span->start = mark.time;
+	span->dur = monotime() - mark.time;
+	span->reqs = NextRequest(disp) - mark.req;
+	span->trips = disp == dpy ? tracetrips - mark.trip : 0;
+	span->tid = disp == dpy ? 1 : 2; /* the bar has its own display */
+	__atomic_store_n(&span->seq, i + 1, __ATOMIC_RELEASE);
+#ifdef TRACEUSDT
+	DTRACE_PROBE3(swim, span, name, span->dur, span->reqs);
+#endif /* TRACEUSDT */
+	if (disp == dpy)
+		checkbudget(span);
+}
+#endif /* TRACE */
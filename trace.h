@@ -0,0 +1,40 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <signal.h>
+
+#include <X11/Xlib.h>
+
+#include "config.h"
+
+#ifdef TRACE
+/* a span from TRACEIN to TRACEOUT, with the requests sent on the display
+ * in between, is kept in a ring dumped as chrome trace json on SIGUSR2;
+ * TRACETRIP precedes each call on the main display waiting on a reply so
+ * its spans count those */
+#define TRACEIN(mark, dpy) Mark mark = tracein(dpy)
+#define TRACEOUT(mark, name, dpy) traceout(mark, name, dpy)
+#define TRACETRIP() ((void)++tracetrips)
+
+typedef struct {
+	long long time;
+	unsigned long req, trip;
+} Mark;
+
+extern volatile sig_atomic_t tracedump;
+extern unsigned long tracetrips; /* main thread only */
+
+void printtrace(void);
+Mark tracein(Display *dpy);
+void traceout(Mark mark, const char *name, Display *dpy);
+#else
+#define TRACEIN(mark, dpy)
+#define TRACEOUT(mark, name, dpy)
+#define TRACETRIP() ((void)0)
+#endif /* TRACE */
+
+#endif /* TRACE_H */
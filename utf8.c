@@ -3,6 +3,11 @@
  * see LICENCE file for licensing information */
 
 #include <stddef.h>
+#include <string.h>
+#if defined(__SSE2__) && __SIZEOF_WCHAR_T__ == 4
+#include <emmintrin.h>
+#define UTF_SSE2
+#endif /* __SSE2__ */
 
 #include "utf8.h"
 #include "util.h"
@@ -10,38 +15,74 @@
 #define UTF_SIZE 4
 #define UTF_INVALID 0xFFFD
 
-static char utf8decodebyte(const char ch, int *ext);
-
-static const char utfbyte[UTF_SIZE + 1] = { 0x80, 0, 0xC0, 0xE0, 0xF0 };
-static const char utfmask[UTF_SIZE + 1] = { 0xC0, 0x80, 0xE0, 0xF0, 0xF8 };
+/* sequence length and payload mask by the high nibble of the first byte,
+ * zero length marks a stray continuation byte */
+static const char utflen[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 2, 2, 3, 4 };
+static const char utfmask[UTF_SIZE + 1] = { 0, 0x7F, 0x1F, 0x0F, 0x07 };
 
 static const int utfmin[UTF_SIZE + 1] = { 0, 0, 0x80, 0x800, 0x10000 };
 static const int utfmax[UTF_SIZE + 1] =
 		{ 0x10FFFF, 0x7F, 0x7FF, 0xFFFF, 0x10FFFF };
 
-static char
-utf8decodebyte(const char ch, int *ext)
-{
-	for (*ext = 0; *ext < (UTF_SIZE + 1); ++(*ext))
-		if ((ch & utfmask[*ext]) == utfbyte[*ext])
-			return ch & ~utfmask[*ext];
-	*ext = -1;
-	return 0;
-}
-
 int
 utf8decode(const char *restrict str, wchar_t *restrict val)
 {
-	int len;
+	unsigned char ch = str[0];
+	if (ch < 0x80) {
+		*val = ch;
+		return 1;
+	}
+
+	int len = utflen[ch >> 4];
 	*val = UTF_INVALID;
-	wchar_t decoded = utf8decodebyte(str[0], &len);
-	for (int i = 1, type; i < len; ++i) {
-		decoded = (decoded << 6) + utf8decodebyte(str[i], &type);
-		if (type != 0)
+	if (len == 0 || (len == UTF_SIZE && ch >= 0xF8))
+		return 1;
+	wchar_t decoded = ch & utfmask[len];
+	for (int i = 1; i < len; ++i) {
+		if (((unsigned char)str[i] & 0xC0) != 0x80)
 			return i;
+		decoded = (decoded << 6) | (str[i] & 0x3F);
 	}
-	if (len >= 1 && decoded <= utfmax[len] && decoded >= utfmin[len] &&
+	if (decoded <= utfmax[len] && decoded >= utfmin[len] &&
 			(decoded < 0xD800 || decoded > 0xDFFF))
 		*val = decoded;
-	return MAX(1, len);
+	return len;
+}
+
+size_t
+utf8decodes(const char *restrict str, size_t bytes, wchar_t *restrict val,
+		unsigned char *restrict len, size_t size)
+{
+	const char *end = str + bytes;
+	size_t num = 0;
+#ifdef UTF_SSE2
+	/* widen ascii sixteen bytes at a time while the loads stay within the
+	 * string, the first chunk holding other bytes hands the rest of the
+	 * call to the scalar loop so other scripts do not pay for the tries */
+	const __m128i zero = _mm_setzero_si128();
+	while (size - num >= 16 && end - str >= 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *)str);
+		int stop = _mm_movemask_epi8(chunk);
+		if (stop != 0) {
+			/* the ascii bytes before the stop are known */
+			for (int i = __builtin_ctz(stop); i > 0; --i)
+				val[num] = *str++, len[num++] = 1;
+			break;
+		}
+		__m128i lo = _mm_unpacklo_epi8(chunk, zero);
+		__m128i hi = _mm_unpackhi_epi8(chunk, zero);
+		__m128i *out = (__m128i *)&val[num];
+		_mm_storeu_si128(&out[0], _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128(&out[1], _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128(&out[2], _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128(&out[3], _mm_unpackhi_epi16(hi, zero));
+		memset(&len[num], 1, 16);
+		str += 16, num += 16;
+	}
+#endif /* UTF_SSE2 */
+	while (num < size && str < end) {
+		len[num] = utf8decode(str, &val[num]);
+		str += len[num++];
+	}
+	return num;
 }
@@ -8,5 +8,9 @@
 #include <stddef.h>
 
 int utf8decode(const char *restrict str, wchar_t *restrict val);
+/* decodes up to size codepoints from the first bytes of str, which must
+ * end on a terminator or a sequence boundary */
+size_t utf8decodes(const char *restrict str, size_t bytes,
+		wchar_t *restrict val, unsigned char *restrict len, size_t size);
 
 #endif /* UTF8_H */
@@ -0,0 +1,105 @@
+/* swim - simple window manager
+ * Copyright (C) 2022 ArcNyxx
+ * see LICENCE file for licensing information */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "utf8.h"
+#include "util.h"
+
+#define ROUNDS 20000 /* decodes of each input a run */
+#define RUNS   7     /* the fastest run is kept */
+#define CHUNK  256   /* codepoints decoded a call, as drw does */
+
+static long long bulk(const char *str, size_t size, wchar_t *val,
+		unsigned char *len);
+static long long single(const char *str, wchar_t *val, unsigned char *len);
+
+static volatile wchar_t sink; /* keeps the codepoints in use */
+
+/* titles as the bar sees them, each repeated to about its buffer size */
+static const struct {
+	const char *name, *text;
+} inputs[] = {
+	{ "ascii",    "vim ~/src/swim/bar.c - swim - simple window manager " },
+	{ "cyrillic", "Привет, мир — Википедия, свободная энциклопедия " },
+	{ "cjk",      "東京都の天気予報・日本気象協会 中文维基百科：自由的百科全书 " },
+	{ "emoji",    "🎉🚀 release notes 😀😃😄😁 🔥🔥🔥 ✨✨ " },
+	{ "mixed",    "Re: 会議の件 — встреча в 15:00 👍 (inbox 12) " },
+};
+
+static long long
+bulk(const char *str, size_t size, wchar_t *val, unsigned char *len)
+{
+	/* each codepoint is taken in turn, as drw walks them */
+	wchar_t sum = 0;
+	long long start = monotime();
+	for (int i = 0; i < ROUNDS; ++i)
+		for (const char *iter = str; iter < str + size;) {
+			size_t num = utf8decodes(iter, str + size - iter, val,
+					len, CHUNK);
+			for (size_t j = 0; j < num; iter += len[j++])
+				sum += val[j];
+		}
+	sink = sum;
+	return monotime() - start;
+}
+
+static long long
+single(const char *str, wchar_t *val, unsigned char *len)
+{
+	wchar_t sum = 0;
+	long long start = monotime();
+	for (int i = 0; i < ROUNDS; ++i)
+		for (const char *iter = str; *iter != '\0'; sum += *val)
+			iter += utf8decode(iter, val);
+	sink = sum;
+	return monotime() - start;
+}
+
+int
+main(void)
+{
+	char str[520];
+	wchar_t val[CHUNK], want;
+	unsigned char len[CHUNK];
+
+	printf("%-10s %6s %12s %12s\n", "input", "bytes", "bulk ns/cp",
+			"single ns/cp");
+	for (int i = 0; i < LENGTH(inputs); ++i) {
+		size_t size = strlen(inputs[i].text), num = 0, cps = 0;
+		for (str[0] = '\0'; num + size < sizeof(str); num += size)
+			strcat(str, inputs[i].text);
+
+		size = strlen(str);
+
+		/* both must agree before either is timed */
+		for (const char *iter = str; *iter != '\0'; cps += num) {
+			num = utf8decodes(iter, str + size - iter, val, len,
+					CHUNK);
+			for (size_t j = 0; j < num; iter += len[j++])
+				if ((int)len[j] != utf8decode(iter, &want) ||
+						val[j] != want)
+					die("utf8bench: %s differs at %zu\n",
+							inputs[i].name,
+							(size_t)(iter - str));
+		}
+
+		long long tbulk = -1, tsingle = -1, time;
+		for (int run = 0; run < RUNS; ++run) {
+			if ((time = bulk(str, size, val, len)) < tbulk ||
+					tbulk == -1)
+				tbulk = time;
+			if ((time = single(str, val, len)) < tsingle ||
+					tsingle == -1)
+				tsingle = time;
+		}
+		printf("%-10s %6zu %12.2f %12.2f\n", inputs[i].name, size,
+				(double)tbulk / ROUNDS / cps,
+				(double)tsingle / ROUNDS / cps);
+	}
+	return 0;
+}
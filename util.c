@@ -3,12 +3,16 @@
  * see LICENCE file for licensing information */
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "util.h"
 
+bool timings = false;
+
 void
 die(const char *fmt, ...)
 {
@@ -23,6 +27,15 @@ die(const char *fmt, ...)
 	exit(1);
 }
 
+long long
+monotime(void)
+{
+	/* nanoseconds */
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 void *
 scalloc(size_t nmemb, size_t size)
 {
@@ -39,3 +52,15 @@ srealloc(void *ptr, size_t size)
 		die("swim: unable to allocate memory");
 	return ptr;
 }
+
+void
+timing(const char *phase)
+{
+	/* the first call marks the start, later ones report time since */
+	static long long start = 0;
+	if (start == 0)
+		start = monotime();
+	else if (timings)
+		fprintf(stderr, "swim: %-8s %8.3fms\n", phase,
+				(monotime() - start) / 1e6);
+}
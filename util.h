@@ -5,6 +5,7 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "grab.h"
@@ -17,11 +18,17 @@
 #define WIDTH(   client) (client->w + 2 * borderw)
 #define HEIGHT(  client) (client->h + 2 * borderw)
 #define TAG              ((1 << LENGTH(tags)) - 1)
+#define CLIMASK          (EnterWindowMask | FocusChangeMask | \
+	PropertyChangeMask | StructureNotifyMask)
 #define CLEAN(   mask)   (mask & ~(numlock | LockMask) & (ShiftMask | \
 	ControlMask | Mod1Mask | Mod2Mask | Mod3Mask | Mod4Mask | Mod5Mask))
 
+extern bool timings;
+
 void die(const char *fmt, ...);
+long long monotime(void);
 void *scalloc(size_t nmemb, size_t size);
 void *srealloc(void *ptr, size_t size);
+void timing(const char *phase);
 
 #endif /* UTIL_H */
@@ -0,0 +1,89 @@
+#!/bin/sh
+# swim - simple window manager
+# Copyright (C) 2022 ArcNyxx
+# see LICENCE file for licensing information
+
+# runs swim on a headless Xvfb with two xinerama screens, driven by
+# swimplay; check records swim under generated load and fails if that
+# recording does not replay to the same clients when recorded again or if
+# swim reports an operation over its budget,
+# bench reports latencies for 10 to 5000 clients
+
+case $1 in
+check) wm=./swim-trace ;;
+bench) wm=./swim ;;
+*) echo 'usage: xvfb.sh check | bench' >&2; exit 1 ;;
+esac
+
+if ! command -v Xvfb >/dev/null; then
+	echo 'xvfb.sh: Xvfb is needed' >&2
+	exit 1
+fi
+
+num=${SWIMDISPLAY:-97}
+dir=$(mktemp -d) || exit 1
+trap 'kill $swim $xvfb 2>/dev/null; rm -rf "$dir"' EXIT
+trap 'exit 1' INT TERM
+
+# waits up to five seconds for a file to appear
+await() {
+	i=0
+	while [ ! -e "$1" ]; do
+		if [ $i -eq 50 ]; then
+			echo "xvfb.sh: $2 did not start" >&2
+			exit 1
+		fi
+		sleep 0.1
+		i=$((i + 1))
+	done
+}
+
+# the clients mapped at the start of a recording, without ids or delays
+clients() {
+	./swimplay -d "$1" | awk '$2 == "prop" || $2 == "map" {
+		$1 = $3 = ""; print }' | head -n 20
+}
+
+start() {
+	rm -f "$dir/sock"
+	$wm --ipc "$dir/sock" "$@" 2>>"$dir/swim.log" &
+	swim=$!
+	await "$dir/sock" swim
+}
+
+Xvfb :$num +xinerama -screen 0 1280x800x24 -screen 1 1280x800x24 \
+	-nolisten tcp >"$dir/xvfb.log" 2>&1 &
+xvfb=$!
+await /tmp/.X11-unix/X$num Xvfb
+export DISPLAY=:$num
+
+case $1 in
+check)
+	# the recording is made by swim itself, so it follows any change to
+	# the format or to what swim records
+	start --record "$dir/load.rec"
+	./swimplay -i "$dir/sock" -r 1 -n 500 -g 20 >"$dir/gen.log" || exit 1
+	kill $swim; wait $swim
+	cat "$dir/gen.log"
+
+	start --record "$dir/again.rec"
+	./swimplay -i "$dir/sock" -s 0 "$dir/load.rec" >"$dir/play.log" ||
+			exit 1
+	kill $swim; wait $swim
+	if ! grep -q ' 0 skipped' "$dir/play.log" ||
+			[ "$(clients "$dir/load.rec")" != \
+			"$(clients "$dir/again.rec")" ]; then
+		echo 'xvfb.sh: the recording did not replay' >&2
+		exit 1
+	fi
+	if grep 'over its budget' "$dir/swim.log" >&2; then
+		exit 1
+	fi
+	;;
+bench)
+	start
+	for n in 10 100 1000 5000; do
+		./swimplay -i "$dir/sock" -r 1 -g $n || exit 1
+	done
+	;;
+esac